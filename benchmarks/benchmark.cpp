@@ -0,0 +1,391 @@
+/**
+ * Benchmark suite: builds scanners for synthetic pattern sets of growing size and scans synthetic corpora,
+ * every configuration is reported as a CSV line (see PrintHeader for columns).
+ *
+ * Usage: benchmarkExec [--corpus-size BYTES] [--max-patterns COUNT] [--memory-limit MB] [--min-time SECONDS] [--seed SEED]
+ *
+ * Corpora and patterns are produced by a fixed seed generator using raw engine output only (standard distributions are
+ * implementation defined), so the same arguments give the same data on every platform.
+ */
+
+#include "AhoCorasick.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#   include <malloc.h>
+#elif defined(__APPLE__)
+#   include <malloc/malloc.h>
+#else
+#   include <malloc.h>
+#endif
+
+#pragma region Heap accounting
+
+static std::atomic<size_t> currentHeap(0);
+static std::atomic<size_t> peakHeap(0);
+
+static size_t GetBlockSize(void* pointer) noexcept
+{
+#if defined(_WIN32)
+    return _msize(pointer);
+#elif defined(__APPLE__)
+    return malloc_size(pointer);
+#else
+    return malloc_usable_size(pointer);
+#endif
+}
+
+// kept out of line, otherwise compiler sees malloc/free paired with new/delete expressions and warns
+#if defined(__GNUC__)
+#   define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#   define BENCHMARK_NOINLINE
+#endif
+
+BENCHMARK_NOINLINE void* operator new(size_t size)
+{
+    void* pointer = std::malloc(size != 0 ? size : 1);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+
+    size_t current = currentHeap += GetBlockSize(pointer);
+    size_t peak = peakHeap;
+    while (current > peak && !peakHeap.compare_exchange_weak(peak, current))
+        ;
+
+    return pointer;
+}
+
+BENCHMARK_NOINLINE void operator delete(void* pointer) noexcept
+{
+    if (pointer == nullptr)
+        return;
+
+    currentHeap -= GetBlockSize(pointer);
+    std::free(pointer);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+#pragma endregion
+
+#pragma region Data generation
+
+enum class CorpusKind
+{
+    Random,
+    Text,
+    Binary
+};
+
+static const char* GetCorpusName(CorpusKind kind)
+{
+    switch (kind)
+    {
+    case CorpusKind::Random: return "random";
+    case CorpusKind::Text: return "text";
+    default: return "binary";
+    }
+}
+
+class Generator
+{
+public:
+    explicit Generator(uint64_t seed) : mEngine(seed) {}
+
+    uint64_t Next() { return mEngine(); }
+
+    size_t Below(size_t bound) { return (size_t)(Next() % bound); }
+
+    /**
+     * \brief English-like word: syllables of consonant + vowel, short words are more frequent.
+     */
+    std::string Word()
+    {
+        static const char consonants[] = "tnshrdlcmwfgypbvk";
+        static const char vowels[] = "eaoiu";
+        size_t syllables = 1 + Below(2) + Below(2) * Below(3);
+        std::string result;
+        for (size_t i = 0; i < syllables; ++i)
+        {
+            result += consonants[Below(sizeof(consonants) - 1) * Below(sizeof(consonants) - 1) / (sizeof(consonants) - 1)];
+            result += vowels[Below(sizeof(vowels) - 1)];
+        }
+
+        if (Below(3) == 0)
+            result += consonants[Below(sizeof(consonants) - 1)];
+
+        return result;
+    }
+
+    std::string Bytes(size_t size)
+    {
+        std::string result(size, '\0');
+        for (auto& c : result)
+            c = (char)(Next() & 0xFF);
+
+        return result;
+    }
+
+private:
+    std::mt19937_64 mEngine;
+};
+
+/**
+ * \brief Makes corpus of the size requested and a pool of patterns, part of which occurs in the corpus.
+ */
+static void Generate(CorpusKind kind, size_t corpusSize, size_t patternCount, uint64_t seed, std::string& corpus,
+    std::vector<std::string>& patterns)
+{
+    Generator generator(seed);
+    corpus.clear();
+    patterns.clear();
+    patterns.reserve(patternCount);
+
+    switch (kind)
+    {
+    case CorpusKind::Random:
+        corpus = generator.Bytes(corpusSize);
+        break;
+    case CorpusKind::Text:
+        while (corpus.size() < corpusSize)
+        {
+            corpus += generator.Word();
+            corpus += generator.Below(12) == 0 ? ". " : " ";
+        }
+
+        corpus.resize(corpusSize);
+        break;
+    case CorpusKind::Binary:
+        corpus = generator.Bytes(corpusSize);
+        break;
+    }
+
+    // every 8th pattern is taken from the corpus (or embedded into it), the rest are (mostly) absent
+    for (size_t i = 0; i < patternCount; ++i)
+    {
+        bool present = i % 8 == 0 && corpusSize > 64;
+        std::string pattern;
+        if (kind == CorpusKind::Text)
+        {
+            if (present)
+                pattern = corpus.substr(generator.Below(corpusSize - 32), 4 + generator.Below(12));
+            else
+            {
+                // phrases of a few words, so large sets don't run out of distinct patterns
+                pattern = generator.Word();
+                while (pattern.size() < 6 || generator.Below(2) == 0)
+                    pattern += " " + generator.Word();
+            }
+        }
+        else
+        {
+            size_t length = 4 + generator.Below(13);
+            if (present && kind == CorpusKind::Random)
+                pattern = corpus.substr(generator.Below(corpusSize - length), length);
+            else
+                pattern = generator.Bytes(length);
+
+            // binary corpus contains signatures at random places
+            if (present && kind == CorpusKind::Binary)
+                corpus.replace(generator.Below(corpusSize - length), length, pattern);
+        }
+
+        patterns.push_back(pattern);
+    }
+}
+
+#pragma endregion
+
+#pragma region Measurement
+
+template <class StringType>
+static StringType Widen(const std::string& source)
+{
+    StringType result;
+    result.reserve(source.size());
+    for (char c : source)
+        result.push_back((typename StringType::value_type)(uint8_t)c);
+
+    return result;
+}
+
+struct Options
+{
+    size_t corpusSize = 16 * 1024 * 1024;
+    size_t maxPatterns = 1000000;
+    size_t memoryLimit = 4096;
+    double minTime = 0.5;
+    uint64_t seed = 20240501;
+};
+
+static const char* GetStrategyName(AhoCorasick::PerformanceStrategy strategy)
+{
+    switch (strategy)
+    {
+    case AhoCorasick::PerformanceStrategy::MaximumPerformance: return "MaximumPerformance";
+    case AhoCorasick::PerformanceStrategy::Balanced: return "Balanced";
+    case AhoCorasick::PerformanceStrategy::Dfa: return "Dfa";
+    default: return "Adaptive";
+    }
+}
+
+static void PrintHeader()
+{
+    std::printf("corpus,type,strategy,engine,patterns,build_s,build_peak_bytes,scanner_bytes,"
+        "scan_bytes,scan_s,mb_per_s,matches,matches_per_s\n");
+}
+
+/**
+ * \brief Builds scanner and measures scanning throughput, prints one CSV line.
+ */
+template <class StringType, AhoCorasick::PerformanceStrategy strategy>
+static void Measure(const char* corpusName, const char* typeName, const std::vector<std::string>& sourcePatterns,
+    const std::string& sourceCorpus, const Options& options)
+{
+    typedef AhoCorasick::Scanner<StringType, strategy> ScannerType;
+    typedef std::chrono::steady_clock Clock;
+    // strategy not applicable to the type falls back to the other one measured anyway
+    if (ScannerType::appliedStrategy != strategy)
+        return;
+
+    // table based strategies need a row per node, skip configurations which surely exceed the memory limit
+    if (strategy == AhoCorasick::PerformanceStrategy::MaximumPerformance || strategy == AhoCorasick::PerformanceStrategy::Dfa)
+    {
+        std::vector<bool> used(256, false);
+        size_t totalLength = 0;
+        for (const auto& pattern : sourcePatterns)
+        {
+            totalLength += pattern.size();
+            for (char c : pattern)
+                used[(uint8_t)c] = true;
+        }
+
+        size_t classCount = std::count(used.begin(), used.end(), true) + 1;
+        if ((double)totalLength * classCount * sizeof(AhoCorasick::NodeId) > (double)options.memoryLimit * 1024 * 1024)
+        {
+            std::printf("%s,%s,%s,skipped,%zu,,,,,,,,\n", corpusName, typeName, GetStrategyName(strategy), 
+                sourcePatterns.size());
+            std::fflush(stdout);
+            return;
+        }
+    }
+
+    std::vector<StringType> patterns;
+    patterns.reserve(sourcePatterns.size());
+    for (const auto& pattern : sourcePatterns)
+        patterns.push_back(Widen<StringType>(pattern));
+
+    StringType corpus = Widen<StringType>(sourceCorpus);
+
+    size_t baseHeap = currentHeap;
+    peakHeap = baseHeap;
+    auto buildStart = Clock::now();
+    std::unique_ptr<ScannerType> scanner(new ScannerType(patterns.begin(), patterns.end()));
+    double buildTime = std::chrono::duration<double>(Clock::now() - buildStart).count();
+    size_t buildPeak = peakHeap - baseHeap;
+    size_t scannerSize = currentHeap - baseHeap;
+
+    size_t matches = 0;
+    size_t scanned = 0;
+    double scanTime = 0;
+    do
+    {
+        auto scanStart = Clock::now();
+        scanner->Scan([&matches](const AhoCorasick::Match<StringType>&)
+        {
+            ++matches;
+            return true;
+        }, corpus.cbegin(), corpus.cend());
+        scanTime += std::chrono::duration<double>(Clock::now() - scanStart).count();
+        scanned += corpus.size() * sizeof(typename StringType::value_type);
+    } while (scanTime < options.minTime);
+
+    std::printf("%s,%s,%s,%s,%zu,%.6f,%zu,%zu,%zu,%.6f,%.2f,%zu,%.0f\n", corpusName, typeName, GetStrategyName(strategy),
+        scanner->GetEngine() == AhoCorasick::ScannerEngine::PackedSimd ? "PackedSimd" : "Automaton",
+        patterns.size(), buildTime, buildPeak, scannerSize, scanned, scanTime, scanned / scanTime / (1024 * 1024), matches,
+        matches / scanTime);
+    std::fflush(stdout);
+}
+
+template <class StringType>
+static void MeasureStrategies(const char* corpusName, const char* typeName, const std::vector<std::string>& patterns,
+    const std::string& corpus, const Options& options)
+{
+    Measure<StringType, AhoCorasick::PerformanceStrategy::Balanced>(corpusName, typeName, patterns, corpus, options);
+    Measure<StringType, AhoCorasick::PerformanceStrategy::MaximumPerformance>(corpusName, typeName, patterns, corpus, options);
+    Measure<StringType, AhoCorasick::PerformanceStrategy::Dfa>(corpusName, typeName, patterns, corpus, options);
+    Measure<StringType, AhoCorasick::PerformanceStrategy::Adaptive>(corpusName, typeName, patterns, corpus, options);
+}
+
+#pragma endregion
+
+static bool ParseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (std::strcmp(argv[i - 1], "--corpus-size") == 0)
+            options.corpusSize = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(argv[i - 1], "--max-patterns") == 0)
+            options.maxPatterns = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(argv[i - 1], "--memory-limit") == 0)
+            options.memoryLimit = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(argv[i - 1], "--min-time") == 0)
+            options.minTime = std::strtod(value, nullptr);
+        else if (std::strcmp(argv[i - 1], "--seed") == 0)
+            options.seed = std::strtoull(value, nullptr, 10);
+        else
+            return false;
+    }
+
+    return options.corpusSize > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::fprintf(stderr, "Usage: %s [--corpus-size BYTES] [--max-patterns COUNT] [--memory-limit MB] "
+            "[--min-time SECONDS] [--seed SEED]\n", argv[0]);
+        return 1;
+    }
+
+    PrintHeader();
+    const CorpusKind kinds[] = { CorpusKind::Random, CorpusKind::Text, CorpusKind::Binary };
+    for (auto kind : kinds)
+    {
+        for (size_t patternCount = 10; patternCount <= options.maxPatterns; patternCount *= 10)
+        {
+            std::string corpus;
+            std::vector<std::string> patterns;
+            Generate(kind, options.corpusSize, patternCount, options.seed, corpus, patterns);
+
+            const char* corpusName = GetCorpusName(kind);
+            MeasureStrategies<std::string>(corpusName, "char", patterns, corpus, options);
+            MeasureStrategies<std::wstring>(corpusName, "wchar_t", patterns, corpus, options);
+            MeasureStrategies<std::vector<uint64_t>>(corpusName, "uint64_t", patterns, corpus, options);
+        }
+    }
+
+    return 0;
+}
@@ -13,14 +13,60 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
 #include <limits>
 #include <map>
+#include <ostream>
 #include <memory>
+#include <mutex>
 #include <string>
-#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if !defined(AHOCORASICK_DISABLE_SIMD)
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define AHOCORASICK_SSE2
+#       include <emmintrin.h>
+#   endif
+#   if defined(__SSSE3__) || defined(__AVX2__)
+#       define AHOCORASICK_SSSE3
+#       include <tmmintrin.h>
+#   endif
+#   if defined(__AVX2__)
+#       define AHOCORASICK_AVX2
+#       include <immintrin.h>
+#   endif
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+#   if !defined(NOMINMAX)
+#       define NOMINMAX
+#       define AHOCORASICK_UNDEF_NOMINMAX
+#   endif
+#   include <windows.h>
+#   if defined(AHOCORASICK_UNDEF_NOMINMAX)
+#       undef NOMINMAX
+#       undef AHOCORASICK_UNDEF_NOMINMAX
+#   endif
+#else
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
 
 namespace AhoCorasick
 {
@@ -29,6 +75,9 @@ namespace AhoCorasick
      * 
      * \tparam StringType Pattern holding container class supporting iterators
      *
+     * <em>word</em> is nullptr for scanners loaded from a file (see Scanner::Load) and for StaticAutomaton, <em>length</em> 
+     * is always valid.
+     *
      */
     template <class StringType>
     struct Match
@@ -36,37 +85,299 @@ namespace AhoCorasick
         size_t offset;
         size_t index;
         const StringType* word;
+        size_t length;
 
         Match(size_t offsetArg, size_t indexArg, const StringType* wordArg) noexcept : 
-            offset(offsetArg), index(indexArg), word(wordArg)
+            offset(offsetArg), index(indexArg), word(wordArg), length(wordArg != nullptr ? wordArg->size() : 0)
+        {}
+
+        Match(size_t offsetArg, size_t indexArg, const StringType* wordArg, size_t lengthArg) noexcept : 
+            offset(offsetArg), index(indexArg), word(wordArg), length(lengthArg)
         {}
     };
 
     /**
      * \brief Allows to select max performance or balnce between perf and memory consumption 
      * 
-     * Strategy defines how child nodes will be stored inside parent nodes. For <em>MaximumPerformance</em> children stored inside array 
-     * with all possible 'character' codes inside making it memory consuming, but fast (access by index with <em>O(1)</em>). 
-     * Otherwise <em>Balanced</em> uses <em>std::map</em> as children container. <em>MaximumPerformance</em> can be enabled only for 1 byte 
-     * sized integer types (for others it will be changed to <em>Balanced</em>).
+     * Strategy defines how parent to child transitions are stored. Nodes themselves are always kept in a single flat array in BFS order
+     * and reference each other by 32-bit ids. For <em>MaximumPerformance</em> every node owns a row of child ids indexed by 'character'
+     * class (each 'character' used by patterns has its own class, all unused ones share a single class) making it memory consuming, 
+     * but fast (access by index with <em>O(1)</em>). Otherwise <em>Balanced</em> binary
+     * searches through node's children, which are adjacent and sorted thanks to the BFS layout. <em>Dfa</em> stores children the same way as 
+     * <em>MaximumPerformance</em> and additionally precomputes every goto transition, so scanning never follows failure links 
+     * (exactly one table lookup per input 'character'). <em>MaximumPerformance</em> and <em>Dfa</em> can be enabled only for 1 byte 
+     * sized integer types (for others it will be changed to <em>Balanced</em>). <em>Adaptive</em> targets wide integer alphabets
+     * (<em>wchar_t</em>, <em>uint64_t</em>, ...) and picks representation per node from its fanout: branch-free search through a small
+     * sorted array, bitmap with popcount rank when children values are close to each other, or hash table for wide nodes like root
+     * (can be enabled only for integer types, for others it will be changed to <em>Balanced</em>).
      *
      */
     enum class PerformanceStrategy
     {
         MaximumPerformance,
-        Balanced
+        Balanced,
+        Dfa,
+        Adaptive
+    };
+
+    /**
+     * \brief Defines which matches Scanner reports.
+     *
+     * <em>All</em> reports every (possibly overlapping) occurrence of every pattern. <em>Existence</em> reports only the first
+     * match found (the one ending first, the longest of them) and stops, it is meant for "does anything match" checks. 
+     * <em>LeftmostFirst</em> and <em>LeftmostLongest</em> report non-overlapping matches: the match starting first wins, 
+     * scanning continues after its end. Among matches starting at the same position <em>LeftmostFirst</em> prefers the pattern 
+     * added first (like regular expression alternation) and <em>LeftmostLongest</em> the longest one. Overlaps are resolved 
+     * during the scan, without collecting overlapping matches. Only <em>All</em> can use the packed engine.
+     */
+    enum class MatchKind
+    {
+        All,
+        Existence,
+        LeftmostFirst,
+        LeftmostLongest
+    };
+
+    /**
+     * \brief Search engine used by Scanner.
+     *
+     * <em>Automaton</em> is the Aho-Corasick automaton built for the strategy selected. <em>PackedSimd</em> is a Teddy-style engine
+     * for small sets of byte patterns: input is filtered by packed nibble masks of the first pattern bytes (SSSE3/AVX2 if enabled 
+     * by compiler target flags, scalar emulation otherwise) and candidates are verified directly. <em>Auto</em> selects
+     * <em>PackedSimd</em> for up to 64 byte patterns when SSSE3 or AVX2 is available and <em>Automaton</em> otherwise. 
+     * <em>PackedSimd</em> is used only for contiguous input (pointers, std::vector and std::basic_string iterators) of 1 byte 
+     * sized integer types, in other cases scanning falls back to the automaton.
+     */
+    enum class ScannerEngine
+    {
+        Auto,
+        Automaton,
+        PackedSimd
+    };
+
+    /**
+     * \brief Normalization applied to patterns when the automaton is built and to input while scanning, so input is scanned 
+     * in place without copying.
+     *
+     * <em>AsciiCaseFolding</em> maps 'A'-'Z' to 'a'-'z'. <em>Custom</em> replaces every 'character' value below 256 by its 
+     * entry of ScannerOptions::translation (larger values are kept). The translation must be idempotent 
+     * (translation[translation[c]] == translation[c]) as case folding is. Applicable to integer 'characters' only. Patterns that
+     * become equal after normalization are duplicates, the only one is kept. ::Match::word points to the original pattern.
+     * Normalization is folded into the byte class map for <em>MaximumPerformance</em> and <em>Dfa</em> (no per 'character' 
+     * cost), the packed engine is not used when normalization is enabled.
+     */
+    enum class Normalization
+    {
+        None,
+        AsciiCaseFolding,
+        Custom
+    };
+
+    /**
+     * \brief Source of memory for temporary structures of automaton construction (C++14 counterpart of 
+     * <em>std::pmr::memory_resource</em>).
+     */
+    class MemoryResource
+    {
+    public:
+        virtual ~MemoryResource() = default;
+
+        /**
+         * \brief Returns block of at least <em>size</em> bytes aligned by <em>alignment</em> (power of 2).
+         */
+        virtual void* Allocate(size_t size, size_t alignment) = 0;
+
+        /**
+         * \brief Releases block returned by Allocate, size and alignment are the same as passed to Allocate.
+         */
+        virtual void Deallocate(void* block, size_t size, size_t alignment) noexcept = 0;
+    };
+
+    /// amount of pattern groups Scanner::ScanGroups can select from
+    static const size_t MaxGroupCount = 64;
+    /// group mask of Scanner::ScanGroups selecting all patterns (no filtering)
+    static const uint64_t AllGroups = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * \brief Scanner construction options.
+     */
+    struct ScannerOptions
+    {
+        ScannerEngine engine = ScannerEngine::Auto;
+        Normalization normalization = Normalization::None;
+        /// translation table used by Normalization::Custom
+        std::array<uint8_t, 256> translation = {};
+        /// amount of threads building the automaton, 0 means std::thread::hardware_concurrency(), doesn't affect the result
+        size_t buildThreadCount = 1;
+        /// memory of the construction trie (kept between updates by UpdatableScanner), nullptr means internal arena released 
+        /// at once with the trie; parts of parallel construction always use internal arenas
+        MemoryResource* memoryResource = nullptr;
+        /// direct lookup of states reachable from root by two 'characters' (1 byte 'characters' only, 256 KB), saves 
+        /// transitions of the widest levels when scanning spends most of the time near root
+        bool rootPairTable = false;
+        /// group (e.g. rule set of a tenant) of every pattern in constructor order, see Scanner::ScanGroups; patterns without
+        /// an entry are in group 0, ids not less than MaxGroupCount mean no group
+        std::vector<uint8_t> groups;
+    };
+
+    /**
+     * \brief Index of node inside the flat node storage. Nodes are laid out in BFS order, so root always has index 0.
+     */
+    typedef uint32_t NodeId;
+
+    static const NodeId RootNodeId = 0;
+    static const NodeId InvalidNodeId = std::numeric_limits<NodeId>::max();
+
+    /**
+     * \brief Resumable scanning state of a single stream: current automaton node and amount of 'characters' consumed.
+     *
+     * State is a small copyable value, so states of many interleaved streams can be kept in a flat array. A default 
+     * constructed state starts a new stream.
+     */
+    struct ScanState
+    {
+        uint64_t offset = 0;
+        NodeId node = RootNodeId;
+        /// next node of the output chain not reported yet because scanning was stopped by callback
+        NodeId pendingMatch = InvalidNodeId;
+    };
+
+    /**
+     * \brief Compact match written by Scanner::ScanRecords, the match starts at endOffset - length.
+     */
+    struct MatchRecord
+    {
+        /// offset right after the last 'character' of the match
+        uint64_t endOffset;
+        /// same as ::Match::index
+        uint32_t index;
+        uint32_t length;
+    };
+
+    /**
+     * \brief Instrumentation policy doing nothing, used by regular scans (calls are optimized out).
+     */
+    struct NoScanStats
+    {
+        static const bool Enabled = false;
+
+        void OnSymbol(uint32_t) noexcept {}
+        void OnSkip(size_t) noexcept {}
+        void OnFailureHop() noexcept {}
+        void OnChainStep() noexcept {}
+        void OnCallback() noexcept {}
+    };
+
+    /**
+     * \brief Counters collected by Scanner::ScanWithStats, can be accumulated over several scans.
+     *
+     * Custom policies must provide the same members (<em>Enabled</em> and On* callbacks).
+     */
+    struct ScanStats
+    {
+        static const bool Enabled = true;
+        /// states deeper than the last bucket are counted in it
+        static const size_t DepthBucketCount = 64;
+
+        /// 'characters' fed to the automaton
+        uint64_t symbols = 0;
+        /// 'characters' skipped by the root filter without visiting the automaton
+        uint64_t skipped = 0;
+        /// failure links followed to find transitions (always 0 for PerformanceStrategy::Dfa)
+        uint64_t failureHops = 0;
+        /// output chain nodes visited (terminal or not)
+        uint64_t chainSteps = 0;
+        /// callback invocations
+        uint64_t callbacks = 0;
+        /// amount of visits of states by depth
+        std::array<uint64_t, DepthBucketCount> depths = {};
+
+        void OnSymbol(uint32_t depth) noexcept
+        {
+            ++symbols;
+            ++depths[depth < DepthBucketCount ? depth : DepthBucketCount - 1];
+        }
+
+        void OnSkip(size_t count) noexcept { skipped += count; }
+        void OnFailureHop() noexcept { ++failureHops; }
+        void OnChainStep() noexcept { ++chainSteps; }
+        void OnCallback() noexcept { ++callbacks; }
+
+        /**
+         * \brief Writes counters as a JSON object.
+         */
+        void Export(std::ostream& stream) const
+        {
+            stream << "{\"symbols\":" << symbols << ",\"skipped\":" << skipped << ",\"failureHops\":" << failureHops
+                << ",\"chainSteps\":" << chainSteps << ",\"callbacks\":" << callbacks << ",\"depths\":[";
+            for (size_t i = 0; i < depths.size(); ++i)
+                stream << (i != 0 ? "," : "") << depths[i];
+
+            stream << "]}";
+        }
     };
 
-    template <class StringType, PerformanceStrategy userStrategy = PerformanceStrategy::Balanced>
+    /**
+     * \brief Structure and memory footprint of a built automaton, see Scanner::GetAutomatonStats.
+     */
+    struct AutomatonStats
+    {
+        /// amount of automaton nodes, root included
+        size_t nodeCount = 0;
+        /// amount of patterns (match indices)
+        size_t patternCount = 0;
+        /// amount of distinct 'characters' on trie edges, table based strategies need a row entry per each one
+        size_t alphabetSize = 0;
+        /// bytes of node array
+        size_t nodeBytes = 0;
+        /// bytes of strategy dependent child lookup structures
+        size_t childrenBytes = 0;
+        /// bytes of root filter, normalization table and packed engine
+        size_t auxiliaryBytes = 0;
+        /// bytes of pattern copies (approximate, 0 for loaded scanners)
+        size_t patternBytes = 0;
+        /// fanouts[n] is amount of nodes having n children
+        std::vector<size_t> fanouts;
+        /// depths[n] is amount of nodes at depth n
+        std::vector<size_t> depths;
+        /// amount of failure links followed from a node to reach root
+        size_t maxFailureChain = 0;
+        double averageFailureChain = 0;
+        /// amount of matches reported when a node is reached (terminal nodes of its output chain)
+        size_t maxOutputChain = 0;
+        double averageOutputChain = 0;
+
+        size_t GetTotalBytes() const noexcept { return nodeBytes + childrenBytes + auxiliaryBytes + patternBytes; }
+    };
+
+    /**
+     * \brief Options of Scanner::ScanParallel.
+     */
+    struct ParallelScanOptions
+    {
+        /// amount of worker threads, 0 means std::thread::hardware_concurrency()
+        size_t threadCount = 0;
+        /// amount of 'characters' per chunk (without overlap), 0 selects it automatically
+        size_t chunkSize = 0;
+        /// if true callback is invoked from the calling thread in the same order as Scanner::Scan does, 
+        /// otherwise it is invoked concurrently from worker threads as soon as chunk matches are found
+        bool ordered = true;
+    };
+
+    template <class StringType, PerformanceStrategy userStrategy = PerformanceStrategy::Balanced, MatchKind kind = MatchKind::All>
     class ScannerImpl;
 
+    template <class StringType, PerformanceStrategy strategy, MatchKind kind>
+    class UpdatableScannerImpl;
+
     template <class ValueType>
     constexpr size_t CanUseMaximumPerformancePolicy() { return sizeof(ValueType) == 1; }
 
     template <class ValueType>
     constexpr std::enable_if_t<std::numeric_limits<ValueType>::is_integer, PerformanceStrategy>  GetPerformanceStrategy(PerformanceStrategy strategy)
     {
-        return CanUseMaximumPerformancePolicy<ValueType>() ? strategy : PerformanceStrategy::Balanced;
+        return (strategy == PerformanceStrategy::Adaptive || CanUseMaximumPerformancePolicy<ValueType>()) ? 
+            strategy : PerformanceStrategy::Balanced;
     }
 
     template <class ValueType>
@@ -86,12 +397,13 @@ namespace AhoCorasick
      * 
      * \tparam StringType Pattern holding container class supporting STL style iterators
      * \tparam strategy Strategy used for a new Scanner
+     * \tparam kind Defines which matches are reported (see ::MatchKind)
      *
      * Actually the only class you need to use the implementation. If you have a small amount of char/byte patterns I recommend to use 
      * <em>MaximumPerformance</em> strategy.
      *
      */
-    template <class StringType, PerformanceStrategy strategy = PerformanceStrategy::Balanced>
+    template <class StringType, PerformanceStrategy strategy = PerformanceStrategy::Balanced, MatchKind kind = MatchKind::All>
     class Scanner
     {
     public:
@@ -121,275 +433,4255 @@ namespace AhoCorasick
             mImpl->Scan(callback, begin, end, continueSearchCallback);
         }
 
-        static const PerformanceStrategy appliedStrategy = GetPerformanceStrategy<ValueType>(strategy);
+        /**
+         * \brief Same as Scan, additionally reports scanning events to instrumentation policy.
+         *
+         * \tparam StatsPolicy ::ScanStats or class with the same interface
+         *
+         * \param stats Policy object, counters are added to the current values
+         *
+         * Always uses the automaton engine. Instrumentation is a separate instantiation of the scanning loop, so Scan isn't
+         * affected by it.
+         *
+         */
+        template <class StatsPolicy, class MatchCallback, class InputIt, 
+            class ContinueSearchCallback = decltype(DefaultContinueSearchCallback<InputIt>)>
+        void ScanWithStats(StatsPolicy& stats, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback = DefaultContinueSearchCallback<InputIt>)
+        {
+            mImpl->ScanWithStats(stats, callback, begin, end, continueSearchCallback);
+        }
 
         /**
-         * \brief Scanner constructor consuming patterns to search.
+         * \brief Same as Scan, reports patterns of the groups selected only (see ScannerOptions::groups).
          *
-         * \tparam WordIt Pattern collection iterator type
-         * 
-         * \param begin First iterator
-         * \param end Last iterator
+         * \param groups Mask of groups, bit <em>i</em> selects group <em>i</em>, ::AllGroups disables filtering
          *
-         * Patterns must be stored in collection supporting iteration (can be a simple array). 
-         * Collection item type must be <em>StringType</em>.
+         * One automaton shared by several rule sets (e.g. of different tenants) scans the input once for any combination
+         * of them. Output chains are filtered inside the engine: every node keeps the union of groups of its output chain, 
+         * so chains without patterns of the selected groups are skipped at once. Match kinds are applied to the patterns
+         * selected (e.g. leftmost match of the selected groups). Always uses the automaton engine when groups are used.
          *
          */
-        template <class WordIt>
-        Scanner(WordIt begin, WordIt end) : 
-            mImpl(std::make_unique<ScannerImpl<StringType, appliedStrategy>>(begin, end))
-        {}
+        template <class MatchCallback, class InputIt, 
+            class ContinueSearchCallback = decltype(DefaultContinueSearchCallback<InputIt>)>
+        void ScanGroups(uint64_t groups, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback = DefaultContinueSearchCallback<InputIt>)
+        {
+            mImpl->ScanGroups(groups, callback, begin, end, continueSearchCallback);
+        }
 
-    private:
-        std::unique_ptr<ScannerImpl<StringType, appliedStrategy>> mImpl;
-    };
+        /**
+         * \brief Returns mask of groups of the pattern with ::Match::index provided.
+         *
+         * Duplicated patterns are reported once with the index of the first occurrence, their mask has groups of all the 
+         * occurrences. Scanner built without groups has all patterns in group 0.
+         */
+        uint64_t GetPatternGroups(size_t index) const noexcept { return mImpl->GetPatternGroups(index); }
 
-#pragma region Implementation
+        /// buffer size of ScanFile and ScanFd reading input which can't be mapped
+        static const size_t DefaultReadBufferSize = 1 << 20;
 
-    template<class ValueType, class StringType, PerformanceStrategy strategy>
-    struct TrieNode;
+        /**
+         * \brief Scans file contents.
+         *
+         * \tparam MatchCallback Function-like callback of bool(::Match)
+         *
+         * \param path File path
+         * \param callback Callback of type ::MatchCallback
+         * \param bufferSize Size of each of two read buffers used if file can't be mapped
+         *
+         * Regular files are memory mapped with sequential access hint and scanned in place without copying, other files
+         * (e.g. named pipes) are read as ScanFd does. Only 1 byte 'characters' are supported. Return value of the callback 
+         * defines if scanning should continue or not.
+         *
+         * \return false if file can't be opened, mapped or read (matches found before a read error are reported)
+         */
+        template <class MatchCallback>
+        bool ScanFile(const std::string& path, const MatchCallback& callback, size_t bufferSize = DefaultReadBufferSize)
+        {
+            static_assert(sizeof(ValueType) == 1, "only 1 byte 'characters' can be scanned from files");
+            return mImpl->ScanFile(path, callback, bufferSize);
+        }
 
-    enum class NodeSearchResult
-    {
-        Added,
-        Found
-    };
+#if !defined(_WIN32)
+        /**
+         * \brief Scans input of a file descriptor till the end (POSIX only).
+         *
+         * \tparam MatchCallback Function-like callback of bool(::Match)
+         *
+         * \param file Descriptor, it isn't closed
+         * \param callback Callback of type ::MatchCallback
+         * \param bufferSize Size of each of two read buffers
+         *
+         * Regular files are mapped and scanned in place from the current position (offsets are counted from it), the 
+         * position is moved to the end. Pipes, sockets and other descriptors are read by a background thread into two 
+         * buffers, so reading of the next buffer overlaps with scanning of the current one. Scanning state is kept between 
+         * buffers, matches spanning them are reported. Only 1 byte 'characters' are supported.
+         *
+         * \return false on read error (matches found before it are reported)
+         */
+        template <class MatchCallback>
+        bool ScanFd(int file, const MatchCallback& callback, size_t bufferSize = DefaultReadBufferSize)
+        {
+            static_assert(sizeof(ValueType) == 1, "only 1 byte 'characters' can be scanned from files");
+            return mImpl->ScanFd(file, callback, bufferSize);
+        }
+#endif
 
-    template <class ValueType, class StringType, PerformanceStrategy strategy>
-    struct NodeChildren
-    {
-        typedef TrieNode<ValueType, StringType, strategy> NodeType;
-        typedef std::map<ValueType, NodeType> MapType;
+        /**
+         * \brief Scans next chunk of a stream resuming from the state provided.
+         *
+         * \tparam InputIt Iterator-like class holding 'character' to scan
+         * \tparam MatchCallback Function-like callback of bool(::Match)
+         *
+         * \param state Stream state, it is updated to continue with the next chunk
+         * \param begin First chunk iterator
+         * \param end Last chunk iterator
+         * \param callback Callback of type ::MatchCallback
+         *
+         * Matches crossing chunk boundaries are reported, offsets are counted from the beginning of the stream. Return value
+         * of the callback defines if scanning should continue or not, after stop state points right after the 'character' 
+         * that completed the last reported match, matches ending at the same 'character' and not reported yet are reported 
+         * first by the next call. Always uses the automaton engine. Leftmost match kinds are not supported (a match may
+         * be resolved only after several chunks).
+         *
+         * \return false if scanning was stopped by callback (or a match was reported for MatchKind::Existence)
+         */
+        template <class InputIt, class MatchCallback>
+        bool Scan(ScanState& state, InputIt begin, InputIt end, const MatchCallback& callback)
+        {
+            static_assert(kind == MatchKind::All || kind == MatchKind::Existence, "streaming scan doesn't support leftmost match kinds");
+            return mImpl->Scan(state, begin, end, callback);
+        }
 
-        NodeSearchResult AddOrGet(const ValueType& value, NodeType*& result) noexcept
+        /**
+         * \brief Scans writing compact match records into the buffer provided instead of invoking a callback per match.
+         *
+         * \tparam InputIt Iterator-like class holding 'character' to scan
+         *
+         * \param state Stream state (see ::ScanState), default constructed one starts a new input
+         * \param begin First input iterator, it is moved right after the last 'character' processed
+         * \param end Last input iterator
+         * \param records Output buffer
+         * \param capacity Size of the buffer in records
+         *
+         * Returns as soon as the buffer is full, the next call with the same state and <em>begin</em> continues from that 
+         * point (remaining matches ending at the same 'character' come first). Matches are the same as Scan reports, offsets 
+         * are counted from the beginning of the input. Records are written inside the scanning loop, so dense matches don't
+         * pay for a callback invocation and ::Match construction each. Always uses the automaton engine, only MatchKind::All
+         * is supported.
+         *
+         * \return amount of records written, less than <em>capacity</em> means the input is exhausted
+         */
+        template <class InputIt>
+        size_t ScanRecords(ScanState& state, InputIt& begin, InputIt end, MatchRecord* records, size_t capacity)
         {
-            auto it = nodes.lower_bound(value);
-            bool found = (it != nodes.end() && it->first == value);
-            if (found)
-            {
-                result = &it->second;
-                return NodeSearchResult::Found;
-            }
+            static_assert(kind == MatchKind::All, "records are supported for MatchKind::All only");
+            return mImpl->ScanRecords(state, begin, end, records, capacity);
+        }
 
-            auto added = nodes.emplace_hint(it, value, NodeType{});
-            result = &added->second;
-            result->value = value;
-            return NodeSearchResult::Added;
+        /**
+         * \brief Counts matches of every pattern.
+         *
+         * \tparam InputIt Iterator-like class holding 'character' to scan
+         * \tparam ContinueSearchCallback Same as for Scan
+         *
+         * \param counts Receives amount of matches Scan would report for every pattern (indexed by ::Match::index)
+         * \param begin First input sequence iterator
+         * \param end Last input sequence iterator
+         *
+         * For MatchKind::All output chains are not walked during the scan: only visits of automaton nodes are counted, then
+         * the counts are summed up over failure links once, so the cost doesn't depend on amount of overlapping matches.
+         *
+         */
+        template <class InputIt, class ContinueSearchCallback = decltype(DefaultContinueSearchCallback<InputIt>)>
+        void Count(std::vector<size_t>& counts, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback = DefaultContinueSearchCallback<InputIt>)
+        {
+            mImpl->Count(counts, begin, end, continueSearchCallback);
         }
 
-        NodeType* TryGet(const ValueType& value) noexcept
+        /**
+         * \brief Scans random access sequence using several threads.
+         *
+         * \tparam MatchCallback Function-like callback of bool(::Match)
+         * \tparam RandomIt Random access iterator holding 'character' to scan
+         *
+         * \param callback Callback of type ::MatchCallback
+         * \param begin First input sequence iterator
+         * \param end Last input sequence iterator
+         * \param options Threading and delivery options (see ::ParallelScanOptions)
+         *
+         * Input is split into chunks, each one is extended backwards by (longest pattern length - 1) 'characters', so matches
+         * crossing chunk boundaries are reported exactly once. The match set is the same as Scan reports. In ordered mode the order
+         * is also the same, unordered mode requires callback to be thread safe. Return value of the callback defines if scanning 
+         * should continue or not, in unordered mode some matches from other chunks may still be reported after stop. Only 
+         * MatchKind::All is scanned in parallel, other kinds depend on the preceding matches and are scanned by the calling thread.
+         *
+         */
+        template <class MatchCallback, class RandomIt>
+        void ScanParallel(const MatchCallback& callback, RandomIt begin, RandomIt end, 
+            const ParallelScanOptions& options = ParallelScanOptions())
         {
-            auto it = nodes.find(value);
-            return it != nodes.end() ? &it->second : nullptr;
+            mImpl->ScanParallel(callback, begin, end, options);
         }
 
-        MapType nodes;
+        /**
+         * \brief Scans several independent sequences advancing them in lockstep.
+         *
+         * \tparam RangeIt Iterator of ranges, each range is a <em>std::pair</em>-like object holding first and last iterators
+         *  of a sequence (forward iterators are required)
+         * \tparam MatchCallback Function-like callback of bool(size_t stream, ::Match)
+         *
+         * \param first First range iterator
+         * \param last Last range iterator
+         * \param callback Callback of type ::MatchCallback, <em>stream</em> is position of the range in [first, last)
+         *
+         * Streams are scanned in groups, every stream of a group makes one step in turn and its next transition is prefetched 
+         * meanwhile, so cache misses of different streams overlap. It pays off for automatons much bigger than cache and many
+         * small sequences. Matches of every stream are reported in the same order as Scan reports them, matches of different 
+         * streams are interleaved. Return value of the callback defines if scanning of the stream should continue or not,
+         * other streams are not affected. Always uses the automaton engine. For leftmost match kinds streams are scanned one 
+         * after another.
+         *
+         */
+        template <class RangeIt, class MatchCallback>
+        void ScanBatch(RangeIt first, RangeIt last, const MatchCallback& callback)
+        {
+            mImpl->ScanBatch(first, last, callback);
+        }
 
-        NodeType* GetFromStorageSlot(typename MapType::value_type& storageSlot) noexcept { return &storageSlot.second; }
-    };
+        static const PerformanceStrategy appliedStrategy = GetPerformanceStrategy<ValueType>(strategy);
 
-    template <class ValueType, class StringType>
-    struct NodeChildren<ValueType, StringType, PerformanceStrategy::MaximumPerformance>
-    {
-        static const PerformanceStrategy strategy = PerformanceStrategy::MaximumPerformance;
+        /**
+         * \brief Scanner constructor consuming patterns to search.
+         *
+         * \tparam WordIt Pattern collection iterator type
+         * 
+         * \param begin First iterator
+         * \param end Last iterator
+         * \param options Construction options (see ::ScannerOptions)
+         *
+         * Patterns must be stored in collection supporting iteration (can be a simple array). 
+         * Collection item type must be <em>StringType</em>.
+         *
+         */
+        template <class WordIt>
+        Scanner(WordIt begin, WordIt end, const ScannerOptions& options = ScannerOptions()) : 
+            mImpl(std::make_unique<ScannerImpl<StringType, appliedStrategy, kind>>(begin, end, options))
+        {}
 
-        typedef TrieNode<ValueType, StringType, strategy> NodeType;
+        /**
+         * \brief Returns engine selected for this scanner, never returns ScannerEngine::Auto.
+         */
+        ScannerEngine GetEngine() const noexcept { return mImpl->GetEngine(); }
 
-        // for signed types lets use signed -> unsigned conversion to avoid shifts
-        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
-        typedef std::array<std::unique_ptr<NodeType>, std::numeric_limits<UnsignedValueType>::max() + 1> ArrayType;
-        ArrayType nodes;
+        /**
+         * \brief Collects node count, memory footprint and trie shape statistics (see ::AutomatonStats).
+         *
+         * Takes time linear in the amount of nodes. Useful for capacity planning: e.g. table based strategies 
+         * (<em>MaximumPerformance</em>, <em>Dfa</em>) need about nodeCount * (alphabetSize + 1) * 4 bytes for children.
+         */
+        AutomatonStats GetAutomatonStats() const { return mImpl->GetAutomatonStats(); }
 
-        NodeType* TryGet(const ValueType& value)
+        /**
+         * \brief Writes automaton to stream in binary format suitable for Load.
+         *
+         * \param stream Output stream, must be opened in binary mode
+         *
+         * The format depends on strategy, 'character' type and byte order, only integer 'characters' are supported.
+         *
+         * \return false on write error
+         */
+        bool Save(std::ostream& stream) const
         {
-            return nodes[(UnsignedValueType)value].get();
+            return mImpl->Save(stream);
         }
 
-        template <class PointerType>
-        void Add(const ValueType& value, PointerType&& node, NodeType*)
+        /**
+         * \brief Creates scanner from file written by Save without rebuilding the automaton.
+         *
+         * \param path File path
+         *
+         * The file is memory mapped and used in place, so loading cost doesn't depend on the automaton size and the pages 
+         * are shared by all processes mapping the same file. Loaded scanner reports matches with <em>word</em> set to nullptr
+         * and always uses the automaton engine.
+         *
+         * \return nullptr if file can't be mapped or was written by incompatible scanner (strategy, 'character' type, 
+         * byte order, format version) or is corrupted
+         */
+        static std::unique_ptr<Scanner> Load(const std::string& path)
         {
-            auto& slot = nodes[(UnsignedValueType)value];
-            slot = std::forward<PointerType>(node);
+            auto impl = ScannerImpl<StringType, appliedStrategy, kind>::Load(path);
+            return impl ? std::unique_ptr<Scanner>(new Scanner(std::move(impl))) : nullptr;
         }
 
-        NodeSearchResult AddOrGet(const ValueType& value, NodeType*& result) noexcept
-        {
-            auto item = TryGet(value);
-            if (item != nullptr)
-            {
-                result = item;
-                return NodeSearchResult::Found;
-            }
-
-            auto& slot = nodes[(UnsignedValueType)value];
-            slot = std::make_unique<NodeType>();
-            result = slot.get();
-            result->value = value;
-            return NodeSearchResult::Added;
-        }
+    private:
+        explicit Scanner(std::unique_ptr<ScannerImpl<StringType, appliedStrategy, kind>> impl) noexcept : mImpl(std::move(impl)) {}
 
-        NodeType* GetFromStorageSlot(typename ArrayType::value_type& storageSlot) noexcept { return storageSlot.get(); }
+        std::unique_ptr<ScannerImpl<StringType, appliedStrategy, kind>> mImpl;
     };
 
-    template<class ValueType, class StringType, PerformanceStrategy strategy>
-    struct TrieNode
+    /**
+     * \brief Scanner allowing to add and remove patterns while other threads are scanning.
+     *
+     * \tparam StringType Pattern holding container class supporting STL style iterators
+     * \tparam strategy Strategy used for automatons (see ::PerformanceStrategy)
+     * \tparam kind Defines which matches are reported (see ::MatchKind)
+     *
+     * Every update builds a new immutable automaton version and publishes it with an atomic pointer swap, scanning threads
+     * never wait for updates: a scan uses the version published when it was started. Replaced versions are freed by later 
+     * updates (or destructor) as soon as no scan started before the swap is running. Updates are serialized with each other.
+     *
+     */
+    template <class StringType, PerformanceStrategy strategy = PerformanceStrategy::Balanced, MatchKind kind = MatchKind::All>
+    class UpdatableScanner
     {
-        size_t matchIndex;
-        TrieNode* failureLink;
-        TrieNode* nextMatchLink;
-        TrieNode* parentLink;
-        ValueType value;
-        StringType word;
-
-        static const size_t InvalidMatchIndex = std::numeric_limits<size_t>::max();
+    public:
+        typedef typename StringType::value_type ValueType;
 
-        NodeChildren<ValueType, StringType, strategy> children;
+        static const PerformanceStrategy appliedStrategy = GetPerformanceStrategy<ValueType>(strategy);
 
-        TrieNode() noexcept : matchIndex(InvalidMatchIndex), failureLink(nullptr), nextMatchLink(nullptr),
-            parentLink(nullptr), value(ValueType())
+        /**
+         * \brief Creates scanner without patterns.
+         *
+         * \param options Construction options applied to every version (see ::ScannerOptions)
+         */
+        explicit UpdatableScanner(const ScannerOptions& options = ScannerOptions()) : 
+            mImpl(std::make_unique<UpdatableScannerImpl<StringType, appliedStrategy, kind>>(options))
         {}
+
+        /**
+         * \brief Same as Scanner::Scan, thread safe and lock free with respect to Update.
+         *
+         * ::Match::index is the id assigned to the pattern when it was added, it is never reused after removal.
+         */
+        template <class MatchCallback, class InputIt, 
+            class ContinueSearchCallback = decltype(DefaultContinueSearchCallback<InputIt>)>
+        void Scan(const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback = DefaultContinueSearchCallback<InputIt>)
+        {
+            mImpl->Scan(callback, begin, end, continueSearchCallback);
+        }
+
+        /**
+         * \brief Adds and removes patterns and publishes the new automaton version.
+         *
+         * \tparam AddIt Iterator of patterns to add
+         * \tparam RemoveIt Iterator of patterns to remove
+         *
+         * \param addBegin First pattern to add
+         * \param addEnd Last pattern to add
+         * \param removeBegin First pattern to remove
+         * \param removeEnd Last pattern to remove
+         *
+         * Removals are applied first. Empty patterns, patterns already present and patterns absent on removal are ignored.
+         * Added patterns get sequential ids in the order of addition.
+         *
+         * \return false if nothing changed (no version is published then)
+         */
+        template <class AddIt, class RemoveIt>
+        bool Update(AddIt addBegin, AddIt addEnd, RemoveIt removeBegin, RemoveIt removeEnd)
+        {
+            return mImpl->Update(addBegin, addEnd, removeBegin, removeEnd);
+        }
+
+        /**
+         * \brief Adds patterns, see Update.
+         */
+        template <class WordIt>
+        bool Add(WordIt begin, WordIt end)
+        {
+            return mImpl->Update(begin, end, end, end);
+        }
+
+        /**
+         * \brief Removes patterns, see Update.
+         */
+        template <class WordIt>
+        bool Remove(WordIt begin, WordIt end)
+        {
+            return mImpl->Update(end, end, begin, end);
+        }
+
+        /**
+         * \brief Returns amount of versions published so far (0 for the initial empty automaton).
+         */
+        uint64_t GetVersion() const noexcept { return mImpl->GetVersion(); }
+
+    private:
+        std::unique_ptr<UpdatableScannerImpl<StringType, appliedStrategy, kind>> mImpl;
+    };
+
+    /**
+     * \brief Returns length of zero terminated string, constexpr replacement of <em>strlen</em>.
+     */
+    constexpr size_t GetStaticLength(const char* pattern) noexcept
+    {
+        size_t length = 0;
+        while (pattern[length] != '\0')
+            ++length;
+
+        return length;
+    }
+
+    /**
+     * \brief Returns amount of trie nodes (root included) StaticAutomaton needs for the patterns.
+     *
+     * Every pattern adds the nodes of its suffix not shared with previous patterns.
+     */
+    template <size_t patternCount>
+    constexpr size_t GetStaticNodeCount(const char* const (&patterns)[patternCount]) noexcept
+    {
+        size_t count = 1;
+        for (size_t i = 0; i < patternCount; ++i)
+        {
+            size_t length = GetStaticLength(patterns[i]);
+            size_t shared = 0;
+            for (size_t j = 0; j < i; ++j)
+            {
+                size_t common = 0;
+                while (common < length && patterns[i][common] == patterns[j][common])
+                    ++common;
+
+                shared = common > shared ? common : shared;
+            }
+
+            count += length - shared;
+        }
+
+        return count;
+    }
+
+    /**
+     * \brief Byte DFA built at compile time from patterns known in advance.
+     *
+     * \tparam nodeCount Amount of trie nodes, use GetStaticNodeCount
+     * \tparam patternCount Amount of patterns
+     *
+     * Create it with MakeStaticAutomaton as <em>constexpr</em> variable: the complete goto function and the output links
+     * are computed by the compiler and stored as read only data, so there is no construction at runtime and nothing is 
+     * allocated. Transitions are stored as the smallest integer type able to hold node ids. Matches are the same as 
+     * Scanner with MatchKind::All reports for the same patterns (empty patterns and duplicates are skipped, indices are 
+     * assigned in order), ::Match::word is nullptr. Compile time cost is about 256 steps per node, large pattern sets 
+     * may require raising the compiler constexpr evaluation limit (<em>-fconstexpr-ops-limit</em>, 
+     * <em>-fconstexpr-steps</em>).
+     *
+     */
+    template <size_t nodeCount, size_t patternCount>
+    class StaticAutomaton
+    {
+    public:
+        typedef std::conditional_t<(nodeCount <= 0x100), uint8_t, 
+            std::conditional_t<(nodeCount <= 0x10000), uint16_t, uint32_t>> StateType;
+
+        static const size_t AlphabetSize = 256;
+        static const uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        constexpr explicit StaticAutomaton(const char* const (&patterns)[patternCount])
+        {
+            for (size_t i = 0; i < nodeCount; ++i)
+                mMatchIndices[i] = InvalidIndex;
+
+            // trie: non-zero entries are children (root is never a child)
+            size_t count = 1;
+            size_t index = 0;
+            for (size_t i = 0; i < patternCount; ++i)
+            {
+                size_t current = 0;
+                size_t length = 0;
+                for (; patterns[i][length] != '\0'; ++length)
+                {
+                    auto& next = mTransitions[current][(uint8_t)patterns[i][length]];
+                    if (next == 0)
+                        next = (StateType)count++;
+
+                    current = next;
+                }
+
+                if (length != 0 && mMatchIndices[current] == InvalidIndex)
+                {
+                    mMatchIndices[current] = (uint32_t)index;
+                    mLengths[index++] = (uint32_t)length;
+                }
+            }
+
+            // BFS: children of a node are found before its row is completed by transitions of the failure link
+            StateType queue[nodeCount] = {};
+            StateType failure[nodeCount] = {};
+            size_t head = 0;
+            size_t tail = 0;
+            for (size_t c = 0; c < AlphabetSize; ++c)
+            {
+                if (mTransitions[0][c] != 0)
+                    queue[tail++] = mTransitions[0][c];
+            }
+
+            while (head < tail)
+            {
+                size_t node = queue[head++];
+                for (size_t c = 0; c < AlphabetSize; ++c)
+                {
+                    size_t child = mTransitions[node][c];
+                    if (child == 0)
+                    {
+                        mTransitions[node][c] = mTransitions[failure[node]][c];
+                        continue;
+                    }
+
+                    size_t link = mTransitions[failure[node]][c];
+                    failure[child] = (StateType)link;
+                    mNextMatches[child] = mMatchIndices[link] != InvalidIndex ? (StateType)link : mNextMatches[link];
+                    queue[tail++] = (StateType)child;
+                }
+            }
+        }
+
+        /**
+         * \brief Returns state reached from <em>state</em> by 'character' <em>value</em>, 0 is the initial state.
+         */
+        constexpr size_t Next(size_t state, char value) const noexcept
+        {
+            return mTransitions[state][(uint8_t)value];
+        }
+
+        /**
+         * \brief Returns index of the longest pattern ending at <em>state</em> or InvalidIndex if there is no such one.
+         */
+        constexpr uint32_t GetMatchIndex(size_t state) const noexcept
+        {
+            return mMatchIndices[state];
+        }
+
+        /**
+         * \brief Same as Scanner::Scan.
+         */
+        template <class MatchCallback, class InputIt, 
+            class ContinueSearchCallback = decltype(DefaultContinueSearchCallback<InputIt>)>
+        void Scan(const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback = DefaultContinueSearchCallback<InputIt>) const
+        {
+            size_t state = 0;
+            size_t offset = 0;
+            do
+            {
+                for (; begin != end; ++begin, ++offset)
+                {
+                    state = mTransitions[state][(uint8_t)*begin];
+                    size_t node = mMatchIndices[state] != InvalidIndex ? state : mNextMatches[state];
+                    // root is never terminal, so 0 ends the output chain
+                    for (; node != 0; node = mNextMatches[node])
+                    {
+                        uint32_t index = mMatchIndices[node];
+                        if (!callback(Match<std::string>(offset + 1 - mLengths[index], index, nullptr, mLengths[index])))
+                            return;
+                    }
+                }
+            } while (continueSearchCallback(begin, end));
+        }
+
+    private:
+        StateType mTransitions[nodeCount][AlphabetSize] = {};
+        uint32_t mMatchIndices[nodeCount] = {};
+        StateType mNextMatches[nodeCount] = {};
+        uint32_t mLengths[patternCount == 0 ? 1 : patternCount] = {};
+    };
+
+    /**
+     * \brief Creates StaticAutomaton, intended for <em>constexpr</em> variables.
+     *
+     * \tparam nodeCount Must be GetStaticNodeCount(patterns)
+     *
+     * \code
+     * static constexpr const char* keywords[] = { "if", "else", "while" };
+     * static constexpr auto automaton = AhoCorasick::MakeStaticAutomaton<AhoCorasick::GetStaticNodeCount(keywords)>(keywords);
+     * \endcode
+     */
+    template <size_t nodeCount, size_t patternCount>
+    constexpr StaticAutomaton<nodeCount, patternCount> MakeStaticAutomaton(const char* const (&patterns)[patternCount])
+    {
+        return StaticAutomaton<nodeCount, patternCount>(patterns);
+    }
+
+    /**
+     * \brief Pattern with a mask per 'character': input 'character' c matches position i if (c & mask[i]) == (value[i] & mask[i]),
+     * i.e. zero mask is a wildcard and all ones mask is an exact 'character'.
+     */
+    template <class StringType>
+    struct MaskedPattern
+    {
+        StringType value;
+        StringType mask;
+    };
+
+    /**
+     * \brief Parses byte signature like "4D 5A ?? ?? 50 45", '?' stands for a wildcard nibble ("4?" matches 40-4F).
+     *
+     * Whitespace between bytes is optional.
+     *
+     * \return false for malformed or empty signature
+     */
+    template <class StringType>
+    bool ParseHexSignature(const std::string& signature, MaskedPattern<StringType>& pattern)
+    {
+        typedef typename StringType::value_type ValueType;
+        static_assert(sizeof(ValueType) == 1, "hex signatures consist of bytes");
+
+        auto parseNibble = [](char c, uint8_t& value, uint8_t& mask)
+        {
+            mask = 0xF;
+            if (c >= '0' && c <= '9')
+                value = (uint8_t)(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                value = (uint8_t)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                value = (uint8_t)(c - 'A' + 10);
+            else if (c == '?')
+                value = mask = 0;
+            else
+                return false;
+
+            return true;
+        };
+
+        pattern.value.clear();
+        pattern.mask.clear();
+        for (size_t i = 0; i < signature.size();)
+        {
+            if (signature[i] == ' ' || signature[i] == '\t')
+            {
+                ++i;
+                continue;
+            }
+
+            uint8_t high = 0, highMask = 0, low = 0, lowMask = 0;
+            if (i + 1 >= signature.size() || !parseNibble(signature[i], high, highMask) || !parseNibble(signature[i + 1], low, lowMask))
+                return false;
+
+            pattern.value.push_back((ValueType)(high << 4 | low));
+            pattern.mask.push_back((ValueType)(highMask << 4 | lowMask));
+            i += 2;
+        }
+
+        return !pattern.value.empty();
+    }
+
+    /**
+     * \brief Scanner of masked patterns (e.g. byte signatures with wildcards).
+     *
+     * \tparam StringType Pattern holding container class of integer 'characters'
+     * \tparam strategy Strategy of the anchor automaton (see ::PerformanceStrategy)
+     *
+     * The longest run of exact 'characters' of every pattern is its anchor. Anchors are searched by a regular Scanner in a 
+     * single pass and every anchor hit is verified against the whole masked pattern around it, so wildcards are never 
+     * expanded and memory is proportional to the total size of patterns. Patterns sharing an anchor share its trie path.
+     * Patterns without exact 'characters' (or with mask size different from value size) can't be anchored and are never 
+     * reported.
+     *
+     */
+    template <class StringType, PerformanceStrategy strategy = PerformanceStrategy::Balanced>
+    class MaskedScanner
+    {
+    public:
+        typedef typename StringType::value_type ValueType;
+
+        /**
+         * \brief Scanner constructor consuming masked patterns.
+         *
+         * \tparam PatternIt Iterator of ::MaskedPattern
+         *
+         * \param begin First iterator
+         * \param end Last iterator
+         * \param options Options of the anchor scanner (see ::ScannerOptions), normalization and groups are not applied 
+         *  (masks can express case insensitivity, e.g. 0xDF for ASCII letters)
+         *
+         */
+        template <class PatternIt>
+        MaskedScanner(PatternIt begin, PatternIt end, const ScannerOptions& options = ScannerOptions()) : mPatterns(begin, end)
+        {
+            static_assert(std::numeric_limits<ValueType>::is_integer, "masked patterns require integer 'characters'");
+
+            // anchors must be unique, so index of an anchor match is its position
+            std::map<StringType, size_t> anchorIds;
+            std::vector<StringType> anchors;
+            std::vector<std::pair<size_t, AnchorUse>> uses;
+            for (size_t i = 0; i < mPatterns.size(); ++i)
+            {
+                AnchorUse use = { i, 0, 0 };
+                if (!FindAnchor(mPatterns[i], use.offset, use.length))
+                    continue;
+
+                auto first = mPatterns[i].value.begin() + use.offset;
+                auto inserted = anchorIds.emplace(StringType(first, first + use.length), anchors.size());
+                if (inserted.second)
+                    anchors.push_back(inserted.first->first);
+
+                uses.emplace_back(inserted.first->second, use);
+            }
+
+            std::stable_sort(uses.begin(), uses.end(), 
+                [](const std::pair<size_t, AnchorUse>& lhs, const std::pair<size_t, AnchorUse>& rhs) { return lhs.first < rhs.first; });
+
+            mUseStarts.assign(anchors.size() + 1, 0);
+            for (const auto& use : uses)
+            {
+                ++mUseStarts[use.first + 1];
+                mUses.push_back(use.second);
+            }
+
+            for (size_t i = 1; i < mUseStarts.size(); ++i)
+                mUseStarts[i] += mUseStarts[i - 1];
+
+            ScannerOptions anchorOptions = options;
+            anchorOptions.normalization = Normalization::None;
+            anchorOptions.groups.clear();
+            mAnchorScanner = std::make_unique<Scanner<StringType, strategy>>(anchors.begin(), anchors.end(), anchorOptions);
+        }
+
+        /**
+         * \brief Scans random access sequence for masked patterns.
+         *
+         * \tparam MatchCallback Function-like callback of bool(::Match)
+         * \tparam RandomIt Random access iterator holding 'character' to scan
+         *
+         * \param callback Callback of type ::MatchCallback
+         * \param begin First input sequence iterator
+         * \param end Last input sequence iterator
+         *
+         * ::Match::index is position of the pattern in constructor input, ::Match::word points to its value. Matches are 
+         * reported in order of their anchors occurrence. Return value of the callback defines if scanning should continue 
+         * or not.
+         *
+         */
+        template <class MatchCallback, class RandomIt>
+        void Scan(const MatchCallback& callback, RandomIt begin, RandomIt end)
+        {
+            size_t size = (size_t)(end - begin);
+            mAnchorScanner->Scan([this, &callback, begin, size](const Match<StringType>& anchor)
+            {
+                for (size_t i = mUseStarts[anchor.index]; i < mUseStarts[anchor.index + 1]; ++i)
+                {
+                    const auto& use = mUses[i];
+                    const auto& pattern = mPatterns[use.pattern];
+                    if (anchor.offset < use.offset || anchor.offset - use.offset + pattern.value.size() > size)
+                        continue;
+
+                    size_t start = anchor.offset - use.offset;
+                    if (!Verify(pattern, use, begin + start))
+                        continue;
+
+                    Match<StringType> m{ start, use.pattern, &pattern.value, pattern.value.size() };
+                    if (!callback(m))
+                        return false;
+                }
+
+                return true;
+            }, begin, end);
+        }
+
+    private:
+        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
+
+        struct AnchorUse
+        {
+            size_t pattern;
+            // position and length of the anchor inside the pattern
+            size_t offset;
+            size_t length;
+        };
+
+        static bool IsExact(const ValueType& mask) noexcept
+        {
+            return (UnsignedValueType)mask == std::numeric_limits<UnsignedValueType>::max();
+        }
+
+        static bool FindAnchor(const MaskedPattern<StringType>& pattern, size_t& offset, size_t& length) noexcept
+        {
+            if (pattern.mask.size() != pattern.value.size())
+                return false;
+
+            length = 0;
+            size_t run = 0;
+            for (size_t i = 0; i < pattern.mask.size(); ++i)
+            {
+                run = IsExact(pattern.mask[i]) ? run + 1 : 0;
+                if (run > length)
+                {
+                    length = run;
+                    offset = i + 1 - run;
+                }
+            }
+
+            return length != 0;
+        }
+
+        template <class RandomIt>
+        static bool Verify(const MaskedPattern<StringType>& pattern, size_t first, size_t last, RandomIt start)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                if ((((UnsignedValueType)start[i] ^ (UnsignedValueType)pattern.value[i]) & (UnsignedValueType)pattern.mask[i]) != 0)
+                    return false;
+            }
+
+            return true;
+        }
+
+        template <class RandomIt>
+        static bool Verify(const MaskedPattern<StringType>& pattern, const AnchorUse& use, RandomIt start)
+        {
+            // the anchor itself is matched by the automaton
+            return Verify(pattern, 0, use.offset, start) && Verify(pattern, use.offset + use.length, pattern.value.size(), start);
+        }
+
+        std::vector<MaskedPattern<StringType>> mPatterns;
+        // uses of anchor i are mUses[mUseStarts[i], mUseStarts[i + 1])
+        std::vector<size_t> mUseStarts;
+        std::vector<AnchorUse> mUses;
+        std::unique_ptr<Scanner<StringType, strategy>> mAnchorScanner;
+    };
+
+#pragma region Implementation
+
+    template<class ValueType>
+    struct TrieNode
+    {
+        uint32_t matchIndex;
+        // length of the path from root, i.e. pattern length for terminal nodes
+        uint32_t depth;
+        NodeId failureLink;
+        NodeId nextMatchLink;
+        NodeId parentLink;
+        // children of a node are stored contiguously (BFS layout) and sorted by value
+        NodeId firstChild;
+        NodeId childCount;
+        ValueType value;
+
+        static const uint32_t InvalidMatchIndex = std::numeric_limits<uint32_t>::max();
+
+        TrieNode() noexcept
+        {
+            // nodes are saved as is, padding included
+            std::memset(this, 0, sizeof(*this));
+            matchIndex = InvalidMatchIndex;
+            failureLink = InvalidNodeId;
+            nextMatchLink = InvalidNodeId;
+            parentLink = InvalidNodeId;
+            firstChild = InvalidNodeId;
+            value = ValueType();
+        }
     };
 
-    template <class StringType, PerformanceStrategy strategy>
-    class ScannerImpl
-    {
-    public:
-        typedef typename StringType::value_type ValueType;
+    /**
+     * \brief Read only array either owning its storage or attached to external memory (e.g. mapped file).
+     */
+    template <class T>
+    class FlatArray
+    {
+    public:
+        FlatArray() noexcept : mData(nullptr), mSize(0) {}
+        FlatArray(const FlatArray&) = delete;
+        FlatArray& operator=(const FlatArray&) = delete;
+
+        void Assign(std::vector<T>&& values) noexcept
+        {
+            mOwned = std::move(values);
+            mData = mOwned.data();
+            mSize = mOwned.size();
+        }
+
+        void Attach(const T* data, size_t size) noexcept
+        {
+            std::vector<T>().swap(mOwned);
+            mData = data;
+            mSize = size;
+        }
+
+        // valid for owned storage only
+        T* MutableData() noexcept { return mOwned.data(); }
+
+        const T& operator[](size_t index) const noexcept { return mData[index]; }
+        const T* data() const noexcept { return mData; }
+        size_t size() const noexcept { return mSize; }
+        bool empty() const noexcept { return mSize == 0; }
+
+    private:
+        std::vector<T> mOwned;
+        const T* mData;
+        size_t mSize;
+    };
+
+    /**
+     * \brief Writes automaton file sections. Every section is a 64 bytes aligned header (element count and size) followed
+     * by the elements, so loaded data is properly aligned inside a mapped file.
+     */
+    class BinaryWriter
+    {
+    public:
+        static const size_t Alignment = 64;
+
+        explicit BinaryWriter(std::ostream& stream) noexcept : mStream(stream), mPosition(0) {}
+
+        void WriteRaw(const void* data, size_t size)
+        {
+            mStream.write((const char*)data, (std::streamsize)size);
+            mPosition += size;
+        }
+
+        template <class T>
+        void WriteSection(const T* data, size_t count)
+        {
+            Align();
+            uint64_t header[Alignment / sizeof(uint64_t)] = { count, sizeof(T) };
+            WriteRaw(header, sizeof(header));
+            WriteRaw(data, count * sizeof(T));
+        }
+
+        template <class T>
+        void WriteValue(const T& value)
+        {
+            WriteSection(&value, 1);
+        }
+
+        bool IsGood() const { return mStream.good(); }
+
+    private:
+        std::ostream& mStream;
+        size_t mPosition;
+
+        void Align()
+        {
+            static const char zeros[Alignment] = {};
+            if (mPosition % Alignment != 0)
+                WriteRaw(zeros, Alignment - mPosition % Alignment);
+        }
+    };
+
+    /**
+     * \brief Reads sections written by BinaryWriter directly from memory without copying.
+     */
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const uint8_t* data, size_t size) noexcept : mData(data), mSize(size), mPosition(0) {}
+
+        bool ReadRaw(void* data, size_t size) noexcept
+        {
+            if (mSize - mPosition < size)
+                return false;
+
+            std::copy(mData + mPosition, mData + mPosition + size, (uint8_t*)data);
+            mPosition += size;
+            return true;
+        }
+
+        template <class T>
+        bool ReadSection(const T*& data, size_t& count) noexcept
+        {
+            mPosition = (mPosition + BinaryWriter::Alignment - 1) / BinaryWriter::Alignment * BinaryWriter::Alignment;
+            uint64_t header[BinaryWriter::Alignment / sizeof(uint64_t)];
+            if (mPosition > mSize || !ReadRaw(header, sizeof(header)) || header[1] != sizeof(T) 
+                || header[0] > (mSize - mPosition) / sizeof(T))
+                return false;
+
+            data = (const T*)(mData + mPosition);
+            count = (size_t)header[0];
+            mPosition += count * sizeof(T);
+            return true;
+        }
+
+        template <class T>
+        bool ReadValue(T& value) noexcept
+        {
+            const T* data = nullptr;
+            size_t count = 0;
+            if (!ReadSection(data, count) || count != 1)
+                return false;
+
+            std::copy((const uint8_t*)data, (const uint8_t*)(data + 1), (uint8_t*)&value);
+            return true;
+        }
+
+        template <class T>
+        bool ReadArray(FlatArray<T>& array) noexcept
+        {
+            const T* data = nullptr;
+            size_t count = 0;
+            if (!ReadSection(data, count))
+                return false;
+
+            array.Attach(data, count);
+            return true;
+        }
+
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+        size_t mPosition;
+    };
+
+    /**
+     * \brief Read only memory mapped file.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() noexcept = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile()
+        {
+#if defined(_WIN32)
+            if (mData != nullptr)
+                UnmapViewOfFile(mData);
+#else
+            if (mData != nullptr)
+                munmap((void*)mData, mSize);
+#endif
+        }
+
+        /**
+         * \brief Maps the whole file, empty file gives empty data.
+         *
+         * \param sequential Hints that data is accessed sequentially (read ahead more aggressively)
+         */
+        bool Open(const std::string& path, bool sequential = false) noexcept
+        {
+#if defined(_WIN32)
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 
+                FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size;
+            HANDLE mapping = nullptr;
+            bool sized = GetFileSizeEx(file, &size) != FALSE;
+            if (sized && size.QuadPart > 0)
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+            CloseHandle(file);
+            // empty file can't be mapped, there is nothing to access anyway
+            if (sized && size.QuadPart == 0)
+                return true;
+
+            if (mapping == nullptr)
+                return false;
+
+            mData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (mData == nullptr)
+                return false;
+
+            mSize = (size_t)size.QuadPart;
+            return true;
+#else
+            int file = open(path.c_str(), O_RDONLY);
+            if (file < 0)
+                return false;
+
+            bool result = Map(file, sequential);
+            close(file);
+            return result;
+#endif
+        }
+
+#if !defined(_WIN32)
+        /**
+         * \brief Maps the whole file referred by descriptor, the descriptor may be closed afterwards.
+         */
+        bool Map(int file, bool sequential = false) noexcept
+        {
+            struct stat info;
+            if (fstat(file, &info) != 0)
+                return false;
+
+            if (info.st_size == 0)
+                return true;
+
+            void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+            if (data == MAP_FAILED)
+                return false;
+
+            if (sequential)
+                posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+
+            mData = (const uint8_t*)data;
+            mSize = (size_t)info.st_size;
+            return true;
+        }
+#endif
+
+        const uint8_t* data() const noexcept { return mData; }
+        size_t size() const noexcept { return mSize; }
+
+    private:
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+    };
+
+#if !defined(_WIN32)
+    /**
+     * \brief Reads descriptor (pipe, socket, ...) by a background thread into two buffers taken by the consumer in turn, 
+     * so reading of the next buffer overlaps with processing of the current one.
+     */
+    class DescriptorReader
+    {
+    public:
+        DescriptorReader(int file, size_t bufferSize) : mFile(file), mProduced(0), mReleased(0), mConsumed(0), 
+            mDone(false), mFailed(false), mStop(false)
+        {
+            for (auto& buffer : mBuffers)
+                buffer.resize(bufferSize != 0 ? bufferSize : 1);
+
+            mThread = std::thread([this]() { Run(); });
+        }
+
+        DescriptorReader(const DescriptorReader&) = delete;
+        DescriptorReader& operator=(const DescriptorReader&) = delete;
+
+        ~DescriptorReader()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+
+            mCondition.notify_all();
+            mThread.join();
+        }
+
+        /**
+         * \brief Takes the next filled buffer, the one taken before is returned to the reader.
+         *
+         * \return false at the end of input or on read error (see IsFailed)
+         */
+        bool Next(const uint8_t*& begin, const uint8_t*& end)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mReleased = mConsumed;
+            mCondition.notify_all();
+            mCondition.wait(lock, [this]() { return mProduced != mConsumed || mDone; });
+            if (mProduced == mConsumed)
+                return false;
+
+            size_t index = mConsumed++ % 2;
+            begin = mBuffers[index].data();
+            end = begin + mSizes[index];
+            return true;
+        }
+
+        bool IsFailed() const noexcept
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mFailed;
+        }
+
+    private:
+        // stop request is checked at least that often while waiting for input
+        static const int PollTimeout = 100;
+
+        void Run()
+        {
+            for (;;)
+            {
+                size_t index = 0;
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mCondition.wait(lock, [this]() { return mProduced - mReleased < 2 || mStop; });
+                    if (mStop)
+                        return;
+
+                    index = mProduced % 2;
+                }
+
+                ssize_t size = ReadSome(mBuffers[index]);
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (size <= 0)
+                {
+                    mFailed = size < 0;
+                    mDone = true;
+                    mCondition.notify_all();
+                    return;
+                }
+
+                mSizes[index] = (size_t)size;
+                ++mProduced;
+                mCondition.notify_all();
+            }
+        }
+
+        /**
+         * \brief Reads available input, 0 means end of input or stop request, -1 means error.
+         */
+        ssize_t ReadSome(std::vector<uint8_t>& buffer)
+        {
+            for (;;)
+            {
+                pollfd request = { mFile, POLLIN, 0 };
+                int ready = poll(&request, 1, PollTimeout);
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mStop)
+                        return 0;
+                }
+
+                // descriptors not supporting poll are read blocking
+                if (ready == 0 || (ready < 0 && errno == EINTR))
+                    continue;
+
+                ssize_t size = read(mFile, buffer.data(), buffer.size());
+                if (size >= 0 || (errno != EINTR && errno != EAGAIN))
+                    return size;
+            }
+        }
+
+        int mFile;
+        std::array<std::vector<uint8_t>, 2> mBuffers;
+        std::array<size_t, 2> mSizes;
+        // buffers filled, returned by consumer and taken by consumer so far
+        size_t mProduced;
+        size_t mReleased;
+        size_t mConsumed;
+        bool mDone;
+        bool mFailed;
+        bool mStop;
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::thread mThread;
+    };
+#endif
+
+    /**
+     * \brief Splits [0, count) into contiguous ranges processed concurrently, the calling thread takes the first one.
+     *
+     * \param function Callback of void(size_t first, size_t last)
+     */
+    template <class Function>
+    void ParallelFor(size_t threadCount, size_t count, const Function& function)
+    {
+        threadCount = std::min(threadCount, count);
+        if (threadCount <= 1)
+        {
+            if (count != 0)
+                function(0, count);
+
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (size_t i = 1; i < threadCount; ++i)
+            threads.emplace_back([&function, i, threadCount, count]() { function(count * i / threadCount, count * (i + 1) / threadCount); });
+
+        function(0, count / threadCount);
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    /**
+     * \brief Global new/delete based resource.
+     */
+    class NewDeleteResource : public MemoryResource
+    {
+    public:
+        void* Allocate(size_t size, size_t) override
+        {
+            return ::operator new(size);
+        }
+
+        void Deallocate(void* block, size_t, size_t) noexcept override
+        {
+            ::operator delete(block);
+        }
+    };
+
+    inline MemoryResource* GetDefaultResource() noexcept
+    {
+        static NewDeleteResource resource;
+        return &resource;
+    }
+
+    /**
+     * \brief Bump pointer allocator: memory is taken from a few growing blocks, deallocation does nothing, all the 
+     * blocks are released by destructor.
+     */
+    class Arena : public MemoryResource
+    {
+    public:
+        Arena() noexcept : mPosition(nullptr), mEnd(nullptr), mNextBlockSize(MinBlockSize) {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* Allocate(size_t size, size_t alignment) override
+        {
+            uintptr_t position = ((uintptr_t)mPosition + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            if (mPosition == nullptr || position + size > (uintptr_t)mEnd)
+            {
+                size_t blockSize = std::max(mNextBlockSize, size + alignment);
+                mBlocks.emplace_back(new uint8_t[blockSize]);
+                if (mNextBlockSize < MaxBlockSize)
+                    mNextBlockSize *= 2;
+
+                mPosition = mBlocks.back().get();
+                mEnd = mPosition + blockSize;
+                position = ((uintptr_t)mPosition + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            }
+
+            mPosition = (uint8_t*)(position + size);
+            return (void*)position;
+        }
+
+        void Deallocate(void*, size_t, size_t) noexcept override {}
+
+    private:
+        static const size_t MinBlockSize = 64 * 1024;
+        static const size_t MaxBlockSize = 64 * 1024 * 1024;
+
+        std::vector<std::unique_ptr<uint8_t[]>> mBlocks;
+        uint8_t* mPosition;
+        uint8_t* mEnd;
+        size_t mNextBlockSize;
+    };
+
+    /**
+     * \brief STL allocator taking memory from MemoryResource, the resource moves together with container content.
+     */
+    template <class T>
+    class ResourceAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        ResourceAllocator() noexcept : mResource(GetDefaultResource()) {}
+        explicit ResourceAllocator(MemoryResource* resource) noexcept : mResource(resource) {}
+
+        template <class U>
+        ResourceAllocator(const ResourceAllocator<U>& other) noexcept : mResource(other.GetResource()) {}
+
+        T* allocate(size_t count)
+        {
+            return (T*)mResource->Allocate(count * sizeof(T), alignof(T));
+        }
+
+        void deallocate(T* block, size_t count) noexcept
+        {
+            mResource->Deallocate(block, count * sizeof(T), alignof(T));
+        }
+
+        MemoryResource* GetResource() const noexcept { return mResource; }
+
+        template <class U>
+        bool operator==(const ResourceAllocator<U>& other) const noexcept { return mResource == other.GetResource(); }
+
+        template <class U>
+        bool operator!=(const ResourceAllocator<U>& other) const noexcept { return mResource != other.GetResource(); }
+
+    private:
+        MemoryResource* mResource;
+    };
+
+    /**
+     * \brief Temporary trie used during construction only, it is flattened into BFS ordered node storage afterwards.
+     */
+    template<class ValueType, class StringType>
+    struct TrieBuilder
+    {
+        typedef ResourceAllocator<std::pair<const ValueType, NodeId>> ChildAllocator;
+
+        struct Node
+        {
+            std::map<ValueType, NodeId, std::less<ValueType>, ChildAllocator> children;
+            uint32_t matchIndex = TrieNode<ValueType>::InvalidMatchIndex;
+
+            Node() = default;
+            explicit Node(MemoryResource* resource) : children(ChildAllocator(resource)) {}
+        };
+
+        // own arenas holding children maps, they must outlive nodes
+        std::vector<std::unique_ptr<Arena>> arenas;
+        MemoryResource* resource;
+        std::vector<Node> nodes;
+        // nodes unlinked by RemoveWord, they stay in storage but are unreachable from root
+        size_t detachedCount = 0;
+
+        explicit TrieBuilder(MemoryResource* memoryResource = nullptr) : resource(memoryResource)
+        {
+            if (resource == nullptr)
+            {
+                arenas.emplace_back(new Arena());
+                resource = arenas.back().get();
+            }
+
+            nodes.emplace_back(resource);
+        }
+
+        TrieBuilder(TrieBuilder&&) = default;
+
+        TrieBuilder& operator=(TrieBuilder&& other) noexcept
+        {
+            // nodes first, the old ones are destroyed while their arenas are still alive
+            nodes = std::move(other.nodes);
+            arenas = std::move(other.arenas);
+            resource = other.resource;
+            detachedCount = other.detachedCount;
+            return *this;
+        }
+
+        template <class NormalizerType>
+        bool AddWord(const StringType& word, size_t matchIndex, const NormalizerType& normalizer)
+        {
+            if (word.empty())
+                return false;
+
+            NodeId current = RootNodeId;
+            for (const auto& original : word)
+            {
+                ValueType c = normalizer(original);
+                auto& children = nodes[current].children;
+                auto it = children.lower_bound(c);
+                if (it != children.end() && it->first == c)
+                {
+                    current = it->second;
+                    continue;
+                }
+
+                NodeId added = (NodeId)nodes.size();
+                children.emplace_hint(it, c, added);
+                nodes.emplace_back(resource);
+                current = added;
+            }
+
+            auto& node = nodes[current];
+            if (node.matchIndex != TrieNode<ValueType>::InvalidMatchIndex)
+                return false;
+
+            node.matchIndex = (uint32_t)matchIndex;
+
+            return true;
+        }
+
+        /**
+         * \brief Returns match index of the pattern, TrieNode::InvalidMatchIndex if there is no such pattern.
+         */
+        template <class NormalizerType>
+        uint32_t FindWord(const StringType& word, const NormalizerType& normalizer) const
+        {
+            NodeId current = RootNodeId;
+            for (const auto& original : word)
+            {
+                const auto& children = nodes[current].children;
+                auto it = children.find(normalizer(original));
+                if (it == children.end())
+                    return TrieNode<ValueType>::InvalidMatchIndex;
+
+                current = it->second;
+            }
+
+            return nodes[current].matchIndex;
+        }
+
+        /**
+         * \brief Removes pattern, nodes which don't lead to any other pattern are unlinked from the trie.
+         *
+         * \return false if there is no such pattern
+         */
+        template <class NormalizerType>
+        bool RemoveWord(const StringType& word, const NormalizerType& normalizer)
+        {
+            std::vector<NodeId> path(1, RootNodeId);
+            std::vector<ValueType> values;
+            for (const auto& original : word)
+            {
+                values.push_back(normalizer(original));
+                const auto& children = nodes[path.back()].children;
+                auto it = children.find(values.back());
+                if (it == children.end())
+                    return false;
+
+                path.push_back(it->second);
+            }
+
+            auto& node = nodes[path.back()];
+            if (path.size() == 1 || node.matchIndex == TrieNode<ValueType>::InvalidMatchIndex)
+                return false;
+
+            node.matchIndex = TrieNode<ValueType>::InvalidMatchIndex;
+            for (size_t i = path.size() - 1; i > 0; --i)
+            {
+                auto& current = nodes[path[i]];
+                if (!current.children.empty() || current.matchIndex != TrieNode<ValueType>::InvalidMatchIndex)
+                    break;
+
+                auto& parent = nodes[path[i - 1]];
+                parent.children.erase(values[i - 1]);
+                ++detachedCount;
+            }
+
+            return true;
+        }
+
+        /**
+         * \brief Moves tries built concurrently into this one, root children of different parts must not intersect.
+         *
+         * \param parts Tries to move, they are left empty
+         * \param indices Maps match indices used by parts to the final ones
+         * \param threadCount Amount of threads moving parts
+         */
+        void Merge(std::vector<TrieBuilder>& parts, const std::vector<uint32_t>& indices, size_t threadCount)
+        {
+            std::vector<size_t> bases(parts.size());
+            size_t total = nodes.size();
+            for (size_t i = 0; i < parts.size(); ++i)
+            {
+                bases[i] = total;
+                total += parts[i].nodes.size();
+            }
+
+            nodes.resize(total);
+            ParallelFor(threadCount, parts.size(), [this, &parts, &indices, &bases](size_t first, size_t last)
+            {
+                for (size_t i = first; i < last; ++i)
+                {
+                    auto& part = parts[i];
+                    for (size_t j = 0; j < part.nodes.size(); ++j)
+                    {
+                        auto& node = nodes[bases[i] + j];
+                        node = std::move(part.nodes[j]);
+                        for (auto& child : node.children)
+                            child.second += (NodeId)bases[i];
+
+                        if (node.matchIndex != TrieNode<ValueType>::InvalidMatchIndex)
+                            node.matchIndex = indices[node.matchIndex];
+                    }
+
+                    part.nodes.clear();
+                }
+            });
+
+            // roots of parts stay unreachable
+            auto& root = nodes[RootNodeId];
+            for (size_t i = 0; i < parts.size(); ++i)
+            {
+                auto& partRoot = nodes[bases[i]];
+                root.children.insert(partRoot.children.begin(), partRoot.children.end());
+                partRoot.children.clear();
+                ++detachedCount;
+                for (auto& arena : parts[i].arenas)
+                    arenas.push_back(std::move(arena));
+            }
+        }
+
+        /**
+         * \brief Copies trie into the flat storage using BFS order, children of every node become adjacent and sorted.
+         */
+        void Flatten(std::vector<TrieNode<ValueType>>& result) const
+        {
+            result.clear();
+            result.reserve(nodes.size());
+            result.emplace_back();
+
+            std::vector<NodeId> order;
+            order.reserve(nodes.size());
+            order.push_back(RootNodeId);
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                const auto& source = nodes[order[i]];
+                auto& target = result[i];
+                target.matchIndex = source.matchIndex;
+                target.firstChild = (NodeId)order.size();
+                target.childCount = (NodeId)source.children.size();
+
+                for (const auto& child : source.children)
+                {
+                    order.push_back(child.second);
+                    result.emplace_back();
+                    result.back().value = child.first;
+                    result.back().parentLink = (NodeId)i;
+                    result.back().depth = target.depth + 1;
+                }
+            }
+        }
+    };
+
+    /**
+     * \brief Hints CPU to fetch cache line holding the address provided, used to overlap memory latency of independent scans.
+     */
+    inline void PrefetchRead(const void* address) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch((const char*)address, _MM_HINT_T0);
+#else
+        (void)address;
+#endif
+    }
+
+    /**
+     * \brief Parent to child lookup structure, depends on strategy. Returns RootNodeId if there is no such child
+     * (root is never a child of any node).
+     */
+    template <class ValueType, class StringType, PerformanceStrategy strategy>
+    struct NodeChildren
+    {
+        typedef TrieNode<ValueType> NodeType;
+
+        // copy of node values to keep binary search cache friendly
+        FlatArray<ValueType> values;
+
+        void Build(const std::vector<NodeType>& nodes)
+        {
+            std::vector<ValueType> result(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i)
+                result[i] = nodes[i].value;
+
+            values.Assign(std::move(result));
+        }
+
+        size_t GetMemoryUsage() const noexcept
+        {
+            return values.size() * sizeof(ValueType);
+        }
+
+        void BuildTransitions(const std::vector<NodeType>&, size_t, size_t) noexcept {}
+
+        // input is normalized by scanner before lookup
+        template <class NormalizerType>
+        void ApplyNormalization(const NormalizerType&) noexcept {}
+
+        void Save(BinaryWriter& writer) const
+        {
+            writer.WriteSection(values.data(), values.size());
+        }
+
+        bool Load(BinaryReader& reader, size_t nodeCount) noexcept
+        {
+            return reader.ReadArray(values) && values.size() == nodeCount;
+        }
+
+        // children position is known only after the node itself is loaded, nothing to prefetch in advance
+        void Prefetch(NodeId, const ValueType&) const noexcept {}
+
+        NodeId TryGet(const NodeType& parent, NodeId, const ValueType& value) const noexcept
+        {
+            auto first = values.data() + parent.firstChild;
+            auto last = first + parent.childCount;
+            auto it = std::lower_bound(first, last, value);
+            return (it != last && *it == value) ? (NodeId)(it - values.data()) : RootNodeId;
+        }
+    };
+
+    template <class ValueType, class StringType>
+    struct NodeChildren<ValueType, StringType, PerformanceStrategy::MaximumPerformance>
+    {
+        typedef TrieNode<ValueType> NodeType;
+
+        // for signed types lets use signed -> unsigned conversion to avoid shifts
+        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
+        static const size_t AlphabetSize = std::numeric_limits<UnsignedValueType>::max() + 1;
+
+        // Alphabet compression: every 'character' used by patterns gets its own class, all the others share
+        // one class (they never have a trie edge). Table rows are indexed by class instead of 'character'.
+        std::array<uint8_t, AlphabetSize> classes;
+        size_t classCount;
+
+        // one row of classCount child ids per node
+        FlatArray<NodeId> table;
+
+        size_t GetMemoryUsage() const noexcept
+        {
+            return sizeof(classes) + table.size() * sizeof(NodeId);
+        }
+
+        void BuildClasses(const std::vector<NodeType>& nodes) noexcept
+        {
+            std::array<bool, AlphabetSize> used;
+            used.fill(false);
+            for (size_t i = 1; i < nodes.size(); ++i)
+                used[(UnsignedValueType)nodes[i].value] = true;
+
+            size_t usedCount = std::count(used.begin(), used.end(), true);
+            // class 0 is reserved for unused 'characters' if any
+            classCount = usedCount == AlphabetSize ? 0 : 1;
+            for (size_t c = 0; c < AlphabetSize; ++c)
+                classes[c] = used[c] ? (uint8_t)classCount++ : 0;
+        }
+
+        void Build(const std::vector<NodeType>& nodes)
+        {
+            BuildClasses(nodes);
+
+            std::vector<NodeId> result(nodes.size() * classCount, RootNodeId);
+            for (size_t i = 1; i < nodes.size(); ++i)
+                result[nodes[i].parentLink * classCount + classes[(UnsignedValueType)nodes[i].value]] = (NodeId)i;
+
+            table.Assign(std::move(result));
+        }
+
+        void BuildTransitions(const std::vector<NodeType>&, size_t, size_t) noexcept {}
+
+        /**
+         * \brief Folds input normalization into the class map: every 'character' gets the class of its normalized value.
+         */
+        template <class NormalizerType>
+        void ApplyNormalization(const NormalizerType& normalizer) noexcept
+        {
+            if (!normalizer.IsEnabled())
+                return;
+
+            auto source = classes;
+            for (size_t c = 0; c < AlphabetSize; ++c)
+                classes[c] = source[(UnsignedValueType)normalizer((ValueType)(UnsignedValueType)c)];
+        }
+
+        void Save(BinaryWriter& writer) const
+        {
+            writer.WriteValue(classes);
+            writer.WriteValue((uint64_t)classCount);
+            writer.WriteSection(table.data(), table.size());
+        }
+
+        bool Load(BinaryReader& reader, size_t nodeCount) noexcept
+        {
+            uint64_t count = 0;
+            if (!reader.ReadValue(classes) || !reader.ReadValue(count) || count > AlphabetSize)
+                return false;
+
+            classCount = (size_t)count;
+            return reader.ReadArray(table) && table.size() == nodeCount * classCount
+                && std::all_of(classes.begin(), classes.end(), [this](uint8_t c) { return c < classCount; })
+                && std::all_of(table.data(), table.data() + table.size(), [nodeCount](NodeId id) { return id < nodeCount; });
+        }
+
+        void Prefetch(NodeId parent, const ValueType& value) const noexcept
+        {
+            PrefetchRead(table.data() + parent * classCount + classes[(UnsignedValueType)value]);
+        }
+
+        NodeId TryGet(const NodeType&, NodeId parent, const ValueType& value) const noexcept
+        {
+            return table[parent * classCount + classes[(UnsignedValueType)value]];
+        }
+    };
+
+    template <class ValueType, class StringType>
+    struct NodeChildren<ValueType, StringType, PerformanceStrategy::Dfa> : 
+        NodeChildren<ValueType, StringType, PerformanceStrategy::MaximumPerformance>
+    {
+        typedef NodeChildren<ValueType, StringType, PerformanceStrategy::MaximumPerformance> BaseType;
+        typedef typename BaseType::NodeType NodeType;
+        using BaseType::table;
+        using BaseType::classes;
+        using BaseType::classCount;
+
+        /**
+         * \brief Turns child table rows of nodes [first, last) into the complete goto function: missing edges are replaced 
+         * by the transition of the failure link node.
+         */
+        void BuildTransitions(const std::vector<NodeType>& nodes, size_t first, size_t last) noexcept
+        {
+            // failure link points to a shallower node, so BFS order guarantees its row is ready
+            auto rows = table.MutableData();
+            for (size_t i = first; i < last; ++i)
+            {
+                auto row = rows + i * classCount;
+                auto failureRow = rows + nodes[i].failureLink * classCount;
+                for (size_t c = 0; c < classCount; ++c)
+                {
+                    if (row[c] == RootNodeId)
+                        row[c] = failureRow[c];
+                }
+            }
+        }
+
+        NodeId GetTransition(NodeId current, const ValueType& value) const noexcept
+        {
+            return table[current * classCount + classes[(typename BaseType::UnsignedValueType)value]];
+        }
+    };
+
+    inline unsigned PopCount64(uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned)__builtin_popcountll(value);
+#else
+        value = value - ((value >> 1) & 0x5555555555555555ull);
+        value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+        value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        return (unsigned)((value * 0x0101010101010101ull) >> 56);
+#endif
+    }
+
+    template <class ValueType, class StringType>
+    struct NodeChildren<ValueType, StringType, PerformanceStrategy::Adaptive> : 
+        NodeChildren<ValueType, StringType, PerformanceStrategy::Balanced>
+    {
+        typedef NodeChildren<ValueType, StringType, PerformanceStrategy::Balanced> BaseType;
+        typedef typename BaseType::NodeType NodeType;
+        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
+        using BaseType::values;
+
+        static const NodeId SmallArrayLimit = 8;
+        static const size_t BitmapSpan = 256;
+        static const size_t BitmapWords = BitmapSpan / 64;
+
+        enum class Kind : uint8_t
+        {
+            SmallArray,
+            Bitmap,
+            Hash
+        };
+
+        struct Layout
+        {
+            ValueType base;   // bitmap: value of the first bit
+            uint32_t aux;     // bitmap: index in bitmaps, hash: index of the first slot in slots
+            uint32_t mask;    // hash: capacity - 1
+            Kind kind;
+        };
+
+        struct BitmapBlock
+        {
+            uint64_t bits[BitmapWords];
+            uint16_t rank[BitmapWords];   // amount of bits set in all previous words
+        };
+
+        FlatArray<Layout> layouts;
+        FlatArray<BitmapBlock> bitmaps;
+        FlatArray<NodeId> slots;
+
+        size_t GetMemoryUsage() const noexcept
+        {
+            return BaseType::GetMemoryUsage() + layouts.size() * sizeof(Layout) + bitmaps.size() * sizeof(BitmapBlock) 
+                + slots.size() * sizeof(NodeId);
+        }
+
+        static uint32_t Hash(const ValueType& value) noexcept
+        {
+            uint64_t h = (uint64_t)(UnsignedValueType)value * 0x9E3779B97F4A7C15ull;
+            return (uint32_t)(h >> 32);
+        }
+
+        void Build(const std::vector<NodeType>& nodes)
+        {
+            BaseType::Build(nodes);
+
+            std::vector<Layout> layouts(nodes.size());
+            // layouts are saved as is, padding included
+            std::memset(layouts.data(), 0, layouts.size() * sizeof(Layout));
+            std::vector<BitmapBlock> bitmaps;
+            std::vector<NodeId> slots;
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                const auto& node = nodes[i];
+                auto& layout = layouts[i];
+                layout.base = ValueType();
+                layout.aux = 0;
+                layout.mask = 0;
+                layout.kind = Kind::SmallArray;
+                if (node.childCount <= SmallArrayLimit)
+                    continue;
+
+                // children are sorted, so the span is defined by the first and the last one
+                auto first = values[node.firstChild];
+                auto last = values[node.firstChild + node.childCount - 1];
+                if ((uint64_t)(UnsignedValueType)((UnsignedValueType)last - (UnsignedValueType)first) < BitmapSpan)
+                {
+                    layout.kind = Kind::Bitmap;
+                    layout.base = first;
+                    layout.aux = (uint32_t)bitmaps.size();
+                    bitmaps.emplace_back();
+
+                    auto& block = bitmaps.back();
+                    std::fill(std::begin(block.bits), std::end(block.bits), 0);
+                    for (NodeId child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+                    {
+                        size_t bit = (UnsignedValueType)((UnsignedValueType)values[child] - (UnsignedValueType)first);
+                        block.bits[bit / 64] |= 1ull << (bit % 64);
+                    }
+
+                    uint16_t rank = 0;
+                    for (size_t w = 0; w < BitmapWords; ++w)
+                    {
+                        block.rank[w] = rank;
+                        rank += (uint16_t)PopCount64(block.bits[w]);
+                    }
+
+                    continue;
+                }
+
+                uint32_t capacity = 1;
+                while (capacity < node.childCount * 2)
+                    capacity <<= 1;
+
+                layout.kind = Kind::Hash;
+                layout.aux = (uint32_t)slots.size();
+                layout.mask = capacity - 1;
+                slots.resize(slots.size() + capacity, RootNodeId);
+
+                auto table = slots.data() + layout.aux;
+                for (NodeId child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+                {
+                    auto slot = Hash(values[child]) & layout.mask;
+                    while (table[slot] != RootNodeId)
+                        slot = (slot + 1) & layout.mask;
+
+                    table[slot] = child;
+                }
+            }
+
+            this->layouts.Assign(std::move(layouts));
+            this->bitmaps.Assign(std::move(bitmaps));
+            this->slots.Assign(std::move(slots));
+        }
+
+        void Save(BinaryWriter& writer) const
+        {
+            BaseType::Save(writer);
+            writer.WriteSection(layouts.data(), layouts.size());
+            writer.WriteSection(bitmaps.data(), bitmaps.size());
+            writer.WriteSection(slots.data(), slots.size());
+        }
+
+        bool Load(BinaryReader& reader, size_t nodeCount) noexcept
+        {
+            if (!BaseType::Load(reader, nodeCount) || !reader.ReadArray(layouts) || layouts.size() != nodeCount
+                || !reader.ReadArray(bitmaps) || !reader.ReadArray(slots))
+                return false;
+
+            auto validLayout = [this](const Layout& layout)
+            {
+                switch (layout.kind)
+                {
+                case Kind::SmallArray: return true;
+                case Kind::Bitmap: return layout.aux < bitmaps.size();
+                case Kind::Hash: return (uint64_t)layout.aux + layout.mask < slots.size() && (layout.mask & (layout.mask + 1)) == 0;
+                default: return false;
+                }
+            };
+
+            return std::all_of(layouts.data(), layouts.data() + layouts.size(), validLayout)
+                && std::all_of(slots.data(), slots.data() + slots.size(), [nodeCount](NodeId id) { return id < nodeCount; });
+        }
+
+        void Prefetch(NodeId parent, const ValueType&) const noexcept
+        {
+            PrefetchRead(layouts.data() + parent);
+        }
+
+        NodeId TryGet(const NodeType& parent, NodeId parentId, const ValueType& value) const noexcept
+        {
+            const auto& layout = layouts[parentId];
+            switch (layout.kind)
+            {
+            case Kind::SmallArray:
+            {
+                // count of children less than value gives position without data dependent branches
+                auto first = values.data() + parent.firstChild;
+                NodeId position = 0;
+                for (NodeId i = 0; i < parent.childCount; ++i)
+                    position += (NodeId)(first[i] < value);
+
+                return (position < parent.childCount && first[position] == value) ? parent.firstChild + position : RootNodeId;
+            }
+            case Kind::Bitmap:
+            {
+                auto bit = (uint64_t)(UnsignedValueType)((UnsignedValueType)value - (UnsignedValueType)layout.base);
+                if (bit >= BitmapSpan)
+                    return RootNodeId;
+
+                const auto& block = bitmaps[layout.aux];
+                auto word = block.bits[bit / 64];
+                auto mask = 1ull << (bit % 64);
+                if ((word & mask) == 0)
+                    return RootNodeId;
+
+                return parent.firstChild + block.rank[bit / 64] + PopCount64(word & (mask - 1));
+            }
+            default:
+            {
+                auto table = slots.data() + layout.aux;
+                for (auto slot = Hash(value) & layout.mask; ; slot = (slot + 1) & layout.mask)
+                {
+                    auto child = table[slot];
+                    if (child == RootNodeId || values[child] == value)
+                        return child;
+                }
+            }
+            }
+        }
+    };
+
+    inline unsigned CountTrailingZeros32(uint32_t value) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(value);
+#endif
+    }
+
+    template <class ValueType>
+    struct IsStringValueType : std::integral_constant<bool, std::is_same<ValueType, char>::value 
+        || std::is_same<ValueType, wchar_t>::value || std::is_same<ValueType, char16_t>::value 
+        || std::is_same<ValueType, char32_t>::value>
+    {};
+
+    template <class InputIt, class ValueType, bool isString = IsStringValueType<ValueType>::value>
+    struct IsStringIterator : std::integral_constant<bool, 
+        std::is_same<InputIt, typename std::basic_string<ValueType>::iterator>::value 
+        || std::is_same<InputIt, typename std::basic_string<ValueType>::const_iterator>::value>
+    {};
+
+    template <class InputIt, class ValueType>
+    struct IsStringIterator<InputIt, ValueType, false> : std::false_type
+    {};
+
+    /**
+     * \brief Detects iterators known to address contiguous memory (pointers, std::vector and std::basic_string iterators).
+     */
+    template <class InputIt, class ValueType = std::remove_cv_t<typename std::iterator_traits<InputIt>::value_type>>
+    struct IsContiguousIterator : std::integral_constant<bool, std::is_pointer<InputIt>::value
+        || std::is_same<InputIt, typename std::vector<ValueType>::iterator>::value
+        || std::is_same<InputIt, typename std::vector<ValueType>::const_iterator>::value
+        || IsStringIterator<InputIt, ValueType>::value>
+    {};
+
+    /**
+     * \brief Normalization of 'characters' (see ::Normalization). Generic version is used for non integer types and does nothing.
+     */
+    template <class ValueType, bool enabled = std::numeric_limits<ValueType>::is_integer>
+    struct Normalizer
+    {
+        void Build(const ScannerOptions&) noexcept {}
+
+        bool IsEnabled() const noexcept { return false; }
+
+        const ValueType& operator()(const ValueType& value) const noexcept { return value; }
+
+        void Save(BinaryWriter&) const {}
+
+        bool Load(BinaryReader&) noexcept { return true; }
+    };
+
+    template <class ValueType>
+    struct Normalizer<ValueType, true>
+    {
+        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
+
+        std::array<uint8_t, 256> table;
+        bool enabled = false;
+
+        void Build(const ScannerOptions& options) noexcept
+        {
+            enabled = options.normalization != Normalization::None;
+            for (size_t c = 0; c < table.size(); ++c)
+            {
+                if (options.normalization == Normalization::Custom)
+                    table[c] = options.translation[c];
+                else if (options.normalization == Normalization::AsciiCaseFolding && c >= 'A' && c <= 'Z')
+                    table[c] = (uint8_t)(c - 'A' + 'a');
+                else
+                    table[c] = (uint8_t)c;
+            }
+        }
+
+        bool IsEnabled() const noexcept { return enabled; }
+
+        ValueType operator()(const ValueType& value) const noexcept
+        {
+            auto unsignedValue = (UnsignedValueType)value;
+            return (unsignedValue >> 8) == 0 ? (ValueType)(UnsignedValueType)table[unsignedValue] : value;
+        }
+
+        void Save(BinaryWriter& writer) const
+        {
+            writer.WriteValue(*this);
+        }
+
+        bool Load(BinaryReader& reader) noexcept
+        {
+            return reader.ReadValue(*this);
+        }
+    };
+
+    /**
+     * \brief Direct lookup of the state reached from root by two 'characters': one table access replaces transitions 
+     * of the root and of its children, the widest nodes of the trie. Generic version does nothing.
+     */
+    template <class ValueType, bool enabled = sizeof(ValueType) == 1 && std::numeric_limits<ValueType>::is_integer>
+    struct RootPairTable
+    {
+        template <class NodeStorage, class StepFunction>
+        void Build(const NodeStorage&, const StepFunction&) {}
+
+        bool IsEnabled() const noexcept { return false; }
+
+        size_t GetMemoryUsage() const noexcept { return 0; }
+
+        void Save(BinaryWriter&) const {}
+
+        bool Load(BinaryReader&, size_t) noexcept { return true; }
+
+        NodeId Get(const ValueType&, const ValueType&) const noexcept { return InvalidNodeId; }
+    };
+
+    template <class ValueType>
+    struct RootPairTable<ValueType, true>
+    {
+        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
+        static const size_t AlphabetSize = std::numeric_limits<UnsignedValueType>::max() + 1;
+
+        // indexed by pair of 'characters', InvalidNodeId if the state after the first one reports matches (the pair 
+        // can't be consumed at once then), empty if disabled
+        FlatArray<NodeId> states;
+
+        /**
+         * \brief Fills the table using step(node, chr) returning the automaton transition.
+         */
+        template <class NodeStorage, class StepFunction>
+        void Build(const NodeStorage& nodes, const StepFunction& step)
+        {
+            std::vector<NodeId> result(AlphabetSize * AlphabetSize);
+            for (size_t first = 0; first < AlphabetSize; ++first)
+            {
+                NodeId middle = step(RootNodeId, (ValueType)(UnsignedValueType)first);
+                const auto& node = nodes[middle];
+                bool reports = node.matchIndex != std::decay_t<decltype(node)>::InvalidMatchIndex 
+                    || node.nextMatchLink != InvalidNodeId;
+                for (size_t second = 0; second < AlphabetSize; ++second)
+                    result[first * AlphabetSize + second] = reports ? InvalidNodeId : step(middle, (ValueType)(UnsignedValueType)second);
+            }
+
+            states.Assign(std::move(result));
+        }
+
+        bool IsEnabled() const noexcept { return !states.empty(); }
+
+        size_t GetMemoryUsage() const noexcept
+        {
+            return states.size() * sizeof(NodeId);
+        }
+
+        void Save(BinaryWriter& writer) const
+        {
+            writer.WriteSection(states.data(), states.size());
+        }
+
+        bool Load(BinaryReader& reader, size_t nodeCount) noexcept
+        {
+            return reader.ReadArray(states) && (states.empty() || states.size() == AlphabetSize * AlphabetSize)
+                && std::all_of(states.data(), states.data() + states.size(), 
+                    [nodeCount](NodeId id) { return id < nodeCount || id == InvalidNodeId; });
+        }
+
+        NodeId Get(const ValueType& first, const ValueType& second) const noexcept
+        {
+            return states[(UnsignedValueType)first * AlphabetSize + (UnsignedValueType)second];
+        }
+    };
+
+    /**
+     * \brief Skips input while automaton stays at root: 'characters' that can't start any pattern are skipped
+     * using vectorized search (when available) without stepping the automaton. Generic version does nothing.
+     */
+    template <class ValueType, bool enabled = sizeof(ValueType) == 1 && std::numeric_limits<ValueType>::is_integer>
+    struct RootFilter
+    {
+        template <class NodeType, class NormalizerType>
+        void Build(const std::vector<NodeType>&, const NormalizerType&) noexcept {}
+
+        void Save(BinaryWriter&) const {}
+
+        bool Load(BinaryReader&) noexcept { return true; }
+
+        template <class InputIt>
+        size_t Skip(InputIt&, const InputIt&) const noexcept { return 0; }
+    };
+
+    template <class ValueType>
+    struct RootFilter<ValueType, true>
+    {
+        typedef std::make_unsigned_t<ValueType> UnsignedValueType;
+        static const size_t AlphabetSize = std::numeric_limits<UnsignedValueType>::max() + 1;
+        // filter is useless if too many 'characters' can start a pattern
+        static const size_t MaxStartCount = AlphabetSize / 4;
+        // up to this amount of start 'characters' plain comparisons are used, nibble lookup tables otherwise
+        static const size_t MaxCompareCount = 3;
+
+        std::array<bool, AlphabetSize> isStart;
+        std::array<uint8_t, MaxCompareCount> compareBytes;
+        // nibble tables: byte b may start a pattern if (low[b & 0xF] & high[b >> 4]) != 0
+        alignas(16) std::array<uint8_t, 16> lowNibbles;
+        alignas(16) std::array<uint8_t, 16> highNibbles;
+        size_t startCount = 0;
+        bool enabled = false;
+
+        RootFilter() noexcept
+        {
+            // filter is saved as is, padding included
+            std::memset(this, 0, sizeof(*this));
+        }
+
+        template <class NodeType, class NormalizerType>
+        void Build(const std::vector<NodeType>& nodes, const NormalizerType& normalizer) noexcept
+        {
+            std::array<bool, AlphabetSize> isRootChild;
+            isRootChild.fill(false);
+            lowNibbles.fill(0);
+            highNibbles.fill(0);
+
+            const auto& root = nodes[RootNodeId];
+            for (NodeId child = root.firstChild; child < root.firstChild + root.childCount; ++child)
+                isRootChild[(UnsignedValueType)nodes[child].value] = true;
+
+            // input is normalized before lookup, so every 'character' normalized to a root child value starts a pattern
+            startCount = 0;
+            for (size_t c = 0; c < AlphabetSize; ++c)
+            {
+                isStart[c] = isRootChild[(UnsignedValueType)normalizer((ValueType)(UnsignedValueType)c)];
+                if (!isStart[c])
+                    continue;
+
+                if (startCount < MaxCompareCount)
+                    compareBytes[startCount] = (uint8_t)c;
+
+                ++startCount;
+            }
+
+            for (size_t i = startCount; i < MaxCompareCount; ++i)
+                compareBytes[i] = compareBytes[0];
+
+            // every distinct set of low nibbles gets its own bit (bits are shared if there are more than 8 sets,
+            // that only adds false positives which are rejected by isStart check)
+            std::array<uint16_t, 16> lowSets;
+            std::array<uint16_t, 8> bitSets;
+            size_t bitCount = 0;
+            for (size_t high = 0; high < 16; ++high)
+            {
+                lowSets[high] = 0;
+                for (size_t low = 0; low < 16; ++low)
+                {
+                    if (isStart[high << 4 | low])
+                        lowSets[high] |= (uint16_t)(1 << low);
+                }
+
+                if (lowSets[high] == 0)
+                    continue;
+
+                size_t bit = 0;
+                while (bit < bitCount && bitSets[bit] != lowSets[high])
+                    ++bit;
+
+                if (bit == bitCount)
+                {
+                    if (bitCount < bitSets.size())
+                        bitSets[bitCount++] = lowSets[high];
+                    else
+                        bit = high % bitSets.size();
+                }
+
+                highNibbles[high] |= (uint8_t)(1 << bit);
+                for (size_t low = 0; low < 16; ++low)
+                {
+                    if ((lowSets[high] & (1 << low)) != 0)
+                        lowNibbles[low] |= (uint8_t)(1 << bit);
+                }
+            }
+
+            enabled = startCount <= MaxStartCount;
+        }
+
+        void Save(BinaryWriter& writer) const
+        {
+            writer.WriteValue(*this);
+        }
+
+        bool Load(BinaryReader& reader) noexcept
+        {
+            return reader.ReadValue(*this);
+        }
+
+        /**
+         * \brief Moves iterator to the next 'character' that can start a pattern.
+         *
+         * \return amount of 'characters' skipped
+         */
+        template <class InputIt>
+        size_t Skip(InputIt& it, const InputIt& end) const noexcept
+        {
+            return enabled ? SkipImpl(it, end, IsContiguousIterator<InputIt>()) : 0;
+        }
+
+    private:
+        template <class InputIt>
+        size_t SkipImpl(InputIt& it, const InputIt& end, std::false_type) const noexcept
+        {
+            size_t skipped = 0;
+            for (; it != end && !isStart[(UnsignedValueType)*it]; ++it)
+                ++skipped;
+
+            return skipped;
+        }
+
+        template <class InputIt>
+        size_t SkipImpl(InputIt& it, const InputIt& end, std::true_type) const noexcept
+        {
+            if (it == end)
+                return 0;
+
+            auto first = (const uint8_t*)&*it;
+            auto last = first + (end - it);
+            auto found = Find(first, last);
+            it += found - first;
+            return (size_t)(found - first);
+        }
+
+        const uint8_t* Find(const uint8_t* begin, const uint8_t* end) const noexcept
+        {
+#if defined(AHOCORASICK_AVX2)
+            if (startCount <= MaxCompareCount)
+            {
+                const __m256i b0 = _mm256_set1_epi8((char)compareBytes[0]);
+                const __m256i b1 = _mm256_set1_epi8((char)compareBytes[1]);
+                const __m256i b2 = _mm256_set1_epi8((char)compareBytes[2]);
+                for (; end - begin >= 32; begin += 32)
+                {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)begin);
+                    __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, b0), _mm256_cmpeq_epi8(v, b1)), 
+                        _mm256_cmpeq_epi8(v, b2));
+                    uint32_t mask = (uint32_t)_mm256_movemask_epi8(eq);
+                    if (mask != 0)
+                        return begin + CountTrailingZeros32(mask);
+                }
+            }
+            else
+            {
+                const __m256i low = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)lowNibbles.data()));
+                const __m256i high = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)highNibbles.data()));
+                const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+                const __m256i zero = _mm256_setzero_si256();
+                while (end - begin >= 32)
+                {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)begin);
+                    __m256i l = _mm256_shuffle_epi8(low, _mm256_and_si256(v, nibbleMask));
+                    __m256i h = _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbleMask));
+                    uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero));
+                    if (mask == 0)
+                    {
+                        begin += 32;
+                        continue;
+                    }
+
+                    auto candidate = begin + CountTrailingZeros32(mask);
+                    if (isStart[*candidate])
+                        return candidate;
+
+                    begin = candidate + 1;
+                }
+            }
+#elif defined(AHOCORASICK_SSE2)
+            if (startCount <= MaxCompareCount)
+            {
+                const __m128i b0 = _mm_set1_epi8((char)compareBytes[0]);
+                const __m128i b1 = _mm_set1_epi8((char)compareBytes[1]);
+                const __m128i b2 = _mm_set1_epi8((char)compareBytes[2]);
+                for (; end - begin >= 16; begin += 16)
+                {
+                    __m128i v = _mm_loadu_si128((const __m128i*)begin);
+                    __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, b0), _mm_cmpeq_epi8(v, b1)), _mm_cmpeq_epi8(v, b2));
+                    uint32_t mask = (uint32_t)_mm_movemask_epi8(eq);
+                    if (mask != 0)
+                        return begin + CountTrailingZeros32(mask);
+                }
+            }
+#   if defined(AHOCORASICK_SSSE3)
+            else
+            {
+                const __m128i low = _mm_load_si128((const __m128i*)lowNibbles.data());
+                const __m128i high = _mm_load_si128((const __m128i*)highNibbles.data());
+                const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+                const __m128i zero = _mm_setzero_si128();
+                while (end - begin >= 16)
+                {
+                    __m128i v = _mm_loadu_si128((const __m128i*)begin);
+                    __m128i l = _mm_shuffle_epi8(low, _mm_and_si128(v, nibbleMask));
+                    __m128i h = _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+                    uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(l, h), zero)) & 0xFFFF;
+                    if (mask == 0)
+                    {
+                        begin += 16;
+                        continue;
+                    }
+
+                    auto candidate = begin + CountTrailingZeros32(mask);
+                    if (isStart[*candidate])
+                        return candidate;
+
+                    begin = candidate + 1;
+                }
+            }
+#   endif
+#endif
+            for (; begin != end && !isStart[*begin]; ++begin);
+            return begin;
+        }
+    };
+
+    /**
+     * \brief Teddy-style matcher for small sets of byte patterns. Patterns are split into buckets, first bytes of patterns are
+     * encoded into per bucket nibble masks, so a block of input positions is filtered by a couple of shuffles. Candidates are 
+     * verified by plain comparison. Generic version is never enabled.
+     */
+    template <class StringType, bool enabled = sizeof(typename StringType::value_type) == 1 
+        && std::numeric_limits<typename StringType::value_type>::is_integer>
+    class PackedMatcher
+    {
+    public:
+        template <class NodeType>
+        void Build(const std::vector<NodeType>&, const std::vector<StringType>&, ScannerEngine) {}
+
+        bool IsEnabled() const noexcept { return false; }
+
+        size_t GetMemoryUsage() const noexcept { return 0; }
+
+        template <class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void Scan(const MatchCallback&, InputIt, InputIt, ContinueSearchCallback) {}
+    };
+
+    template <class StringType>
+    class PackedMatcher<StringType, true>
+    {
+    public:
+        static const size_t MaxAutoPatternCount = 64;
+        static const size_t BucketCount = 8;
+        static const size_t MaxMaskLength = 3;
+
+#if defined(AHOCORASICK_SSSE3)
+        static const bool HasSimd = true;
+#else
+        static const bool HasSimd = false;
+#endif
+
+        template <class NodeType>
+        void Build(const std::vector<NodeType>& nodes, const std::vector<StringType>& words, ScannerEngine engine)
+        {
+            mEnabled = false;
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                const auto& node = nodes[i];
+                if (node.matchIndex == NodeType::InvalidMatchIndex)
+                    continue;
+
+                Pattern pattern;
+                pattern.offset = mBytes.size();
+                pattern.length = node.depth;
+                pattern.index = node.matchIndex;
+                pattern.word = &words[node.matchIndex];
+                for (auto c : words[node.matchIndex])
+                    mBytes.push_back((uint8_t)c);
+
+                mPatterns.push_back(pattern);
+            }
+
+            if (mPatterns.empty() || engine == ScannerEngine::Automaton)
+                return;
+
+            if (engine == ScannerEngine::Auto && (!HasSimd || mPatterns.size() > MaxAutoPatternCount))
+                return;
+
+            mEnabled = true;
+            mMaskLength = MaxMaskLength;
+            mMaxLength = 0;
+            for (const auto& pattern : mPatterns)
+            {
+                mMaskLength = std::min(mMaskLength, pattern.length);
+                mMaxLength = std::max(mMaxLength, pattern.length);
+            }
+
+            // patterns with similar prefixes share a bucket, that keeps masks selective
+            std::sort(mPatterns.begin(), mPatterns.end(), [this](const Pattern& lhs, const Pattern& rhs)
+            {
+                return std::lexicographical_compare(mBytes.begin() + lhs.offset, mBytes.begin() + lhs.offset + mMaskLength,
+                    mBytes.begin() + rhs.offset, mBytes.begin() + rhs.offset + mMaskLength);
+            });
+
+            for (auto& mask : mLow)
+                mask.fill(0);
+            for (auto& mask : mHigh)
+                mask.fill(0);
+            for (auto& mask : mExact)
+                mask.fill(0);
+
+            for (size_t i = 0; i < mPatterns.size(); ++i)
+            {
+                size_t bucket = i * BucketCount / mPatterns.size();
+                mBuckets[bucket].push_back((uint32_t)i);
+
+                auto bytes = mBytes.data() + mPatterns[i].offset;
+                for (size_t j = 0; j < mMaskLength; ++j)
+                {
+                    auto bit = (uint8_t)(1 << bucket);
+                    mLow[j][bytes[j] & 0x0F] |= bit;
+                    mHigh[j][bytes[j] >> 4] |= bit;
+                    mExact[j][bytes[j]] |= bit;
+                }
+            }
+        }
+
+        bool IsEnabled() const noexcept { return mEnabled; }
+
+        size_t GetMemoryUsage() const noexcept
+        {
+            if (!mEnabled)
+                return 0;
+
+            size_t result = sizeof(mLow) + sizeof(mHigh) + sizeof(mExact) + mPatterns.capacity() * sizeof(Pattern) 
+                + mBytes.capacity();
+            for (const auto& bucket : mBuckets)
+                result += bucket.capacity() * sizeof(uint32_t);
+
+            return result;
+        }
+
+        template <class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void Scan(const MatchCallback& callback, InputIt begin, InputIt end, ContinueSearchCallback continueSearchCallback)
+        {
+            ScanContext context;
+            size_t base = 0;
+            do
+            {
+                auto first = begin != end ? (const uint8_t*)&*begin : nullptr;
+                auto last = first + (end - begin);
+                if (!ScanBoundary(context, callback, first, last, base) || !ScanBuffer(context, callback, first, last, base)
+                    || !Flush(context, callback, std::numeric_limits<size_t>::max()))
+                    return;
+
+                UpdateCarry(context, first, last);
+                base += last - first;
+            } while (continueSearchCallback(begin, end));
+        }
+
+    private:
+        struct Pattern
+        {
+            size_t offset;
+            size_t length;
+            size_t index;
+            const StringType* word;
+        };
+
+        struct PendingMatch
+        {
+            size_t end;
+            const Pattern* pattern;
+        };
+
+        struct ScanContext
+        {
+            // matches found, but not reported yet (to keep automaton reporting order)
+            std::vector<PendingMatch> pending;
+            // last mMaxLength - 1 bytes of previous buffers
+            std::vector<uint8_t> carry;
+        };
+
+        std::vector<Pattern> mPatterns;
+        std::vector<uint8_t> mBytes;
+        std::array<std::vector<uint32_t>, BucketCount> mBuckets;
+        alignas(16) std::array<std::array<uint8_t, 16>, MaxMaskLength> mLow;
+        alignas(16) std::array<std::array<uint8_t, 16>, MaxMaskLength> mHigh;
+        std::array<std::array<uint8_t, 256>, MaxMaskLength> mExact;
+        size_t mMaskLength = 0;
+        size_t mMaxLength = 0;
+        bool mEnabled = false;
+
+        /**
+         * \brief Reports pending matches ending before position, order is the same as automaton one: by end offset
+         * and the longest first for the same end.
+         */
+        template <class MatchCallback>
+        static bool Flush(ScanContext& context, const MatchCallback& callback, size_t position)
+        {
+            auto& pending = context.pending;
+            size_t reported = 0;
+            for (; reported < pending.size() && pending[reported].end < position; ++reported)
+            {
+                const auto& pattern = *pending[reported].pattern;
+                Match<StringType> m{ pending[reported].end + 1 - pattern.length, pattern.index, pattern.word, pattern.length };
+                if (!callback(m))
+                    return false;
+            }
+
+            pending.erase(pending.begin(), pending.begin() + reported);
+            return true;
+        }
+
+        template <class MatchCallback>
+        static bool AddMatch(ScanContext& context, const MatchCallback& callback, size_t start, const Pattern& pattern)
+        {
+            // nothing ending before start can be found anymore
+            if (!Flush(context, callback, start))
+                return false;
+
+            PendingMatch match{ start + pattern.length - 1, &pattern };
+            auto& pending = context.pending;
+            auto it = std::upper_bound(pending.begin(), pending.end(), match, [](const PendingMatch& lhs, const PendingMatch& rhs)
+            {
+                return lhs.end < rhs.end || (lhs.end == rhs.end && lhs.pattern->length > rhs.pattern->length);
+            });
+
+            pending.insert(it, match);
+            return true;
+        }
+
+        template <class MatchCallback>
+        bool Verify(ScanContext& context, const MatchCallback& callback, const uint8_t* position, const uint8_t* last, 
+            uint8_t buckets, size_t start) const
+        {
+            for (size_t bucket = 0; buckets != 0; ++bucket, buckets >>= 1)
+            {
+                if ((buckets & 1) == 0)
+                    continue;
+
+                for (auto patternIndex : mBuckets[bucket])
+                {
+                    const auto& pattern = mPatterns[patternIndex];
+                    if ((size_t)(last - position) >= pattern.length
+                        && std::equal(position, position + pattern.length, mBytes.data() + pattern.offset))
+                    {
+                        if (!AddMatch(context, callback, start, pattern))
+                            return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        uint8_t GetExactBuckets(const uint8_t* position) const noexcept
+        {
+            uint8_t buckets = 0xFF;
+            for (size_t j = 0; j < mMaskLength; ++j)
+                buckets &= mExact[j][position[j]];
+
+            return buckets;
+        }
+
+        template <class MatchCallback>
+        bool ScanBuffer(ScanContext& context, const MatchCallback& callback, const uint8_t* first, const uint8_t* last, 
+            size_t base) const
+        {
+            auto position = first;
+#if defined(AHOCORASICK_SSSE3)
+            bool completed = true;
+            if (mMaskLength == 1)
+                completed = ScanBlocks<1>(context, callback, first, last, base, position);
+            else if (mMaskLength == 2)
+                completed = ScanBlocks<2>(context, callback, first, last, base, position);
+            else
+                completed = ScanBlocks<3>(context, callback, first, last, base, position);
+
+            if (!completed)
+                return false;
+#endif
+
+            for (; (size_t)(last - position) >= mMaskLength; ++position)
+            {
+                auto buckets = GetExactBuckets(position);
+                if (buckets != 0 && !Verify(context, callback, position, last, buckets, base + (position - first)))
+                    return false;
+            }
+
+            return true;
+        }
+
+#if defined(AHOCORASICK_AVX2)
+        /**
+         * \brief Filters input by blocks of 32 positions, position is set to the first one not processed yet.
+         *
+         * \return false if callback requested to stop
+         */
+        template <size_t maskLength, class MatchCallback>
+        bool ScanBlocks(ScanContext& context, const MatchCallback& callback, const uint8_t* first, 
+            const uint8_t* last, size_t base, const uint8_t*& position) const
+        {
+            const size_t lanes = 32;
+            const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i low[maskLength], high[maskLength];
+            for (size_t j = 0; j < maskLength; ++j)
+            {
+                low[j] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)mLow[j].data()));
+                high[j] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)mHigh[j].data()));
+            }
+
+            alignas(32) uint8_t buckets[lanes];
+            for (; (size_t)(last - position) >= lanes + maskLength - 1; position += lanes)
+            {
+                __m256i result = _mm256_set1_epi8((char)0xFF);
+                for (size_t j = 0; j < maskLength; ++j)
+                {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)(position + j));
+                    __m256i l = _mm256_shuffle_epi8(low[j], _mm256_and_si256(v, nibbleMask));
+                    __m256i h = _mm256_shuffle_epi8(high[j], _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbleMask));
+                    result = _mm256_and_si256(result, _mm256_and_si256(l, h));
+                }
+
+                uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(result, zero));
+                if (mask == 0)
+                    continue;
+
+                _mm256_store_si256((__m256i*)buckets, result);
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    auto lane = CountTrailingZeros32(mask);
+                    if (!Verify(context, callback, position + lane, last, buckets[lane], base + (position + lane - first)))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+#elif defined(AHOCORASICK_SSSE3)
+        /**
+         * \brief Filters input by blocks of 16 positions, position is set to the first one not processed yet.
+         *
+         * \return false if callback requested to stop
+         */
+        template <size_t maskLength, class MatchCallback>
+        bool ScanBlocks(ScanContext& context, const MatchCallback& callback, const uint8_t* first, 
+            const uint8_t* last, size_t base, const uint8_t*& position) const
+        {
+            const size_t lanes = 16;
+            const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+            const __m128i zero = _mm_setzero_si128();
+            __m128i low[maskLength], high[maskLength];
+            for (size_t j = 0; j < maskLength; ++j)
+            {
+                low[j] = _mm_load_si128((const __m128i*)mLow[j].data());
+                high[j] = _mm_load_si128((const __m128i*)mHigh[j].data());
+            }
+
+            alignas(16) uint8_t buckets[lanes];
+            for (; (size_t)(last - position) >= lanes + maskLength - 1; position += lanes)
+            {
+                __m128i result = _mm_set1_epi8((char)0xFF);
+                for (size_t j = 0; j < maskLength; ++j)
+                {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(position + j));
+                    __m128i l = _mm_shuffle_epi8(low[j], _mm_and_si128(v, nibbleMask));
+                    __m128i h = _mm_shuffle_epi8(high[j], _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+                    result = _mm_and_si128(result, _mm_and_si128(l, h));
+                }
+
+                uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(result, zero)) & 0xFFFF;
+                if (mask == 0)
+                    continue;
+
+                _mm_store_si128((__m128i*)buckets, result);
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    auto lane = CountTrailingZeros32(mask);
+                    if (!Verify(context, callback, position + lane, last, buckets[lane], base + (position + lane - first)))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+#endif
+
+        /**
+         * \brief Finds matches starting inside bytes carried from previous buffers and ending inside the new one.
+         */
+        template <class MatchCallback>
+        bool ScanBoundary(ScanContext& context, const MatchCallback& callback, const uint8_t* first, const uint8_t* last, 
+            size_t base) const
+        {
+            auto& carry = context.carry;
+            if (carry.empty() || first == last)
+                return true;
+
+            std::vector<uint8_t> window(carry);
+            window.insert(window.end(), first, first + std::min<size_t>(last - first, mMaxLength - 1));
+            for (size_t start = 0; start < carry.size(); ++start)
+            {
+                for (const auto& pattern : mPatterns)
+                {
+                    if (start + pattern.length <= carry.size() || start + pattern.length > window.size())
+                        continue;
+
+                    if (std::equal(window.begin() + start, window.begin() + start + pattern.length, mBytes.data() + pattern.offset)
+                        && !AddMatch(context, callback, base - carry.size() + start, pattern))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        void UpdateCarry(ScanContext& context, const uint8_t* first, const uint8_t* last) const
+        {
+            auto& carry = context.carry;
+            carry.insert(carry.end(), last - std::min<size_t>(last - first, mMaxLength - 1), last);
+            if (carry.size() > mMaxLength - 1)
+                carry.erase(carry.begin(), carry.end() - (mMaxLength - 1));
+        }
+    };
+
+    /**
+     * \brief Shared state of ScanParallel workers and consumer.
+     */
+    template <class StringType>
+    struct ParallelScanContext
+    {
+        struct Chunk
+        {
+            std::vector<Match<StringType>> matches;
+            bool ready = false;
+        };
+
+        std::vector<Chunk> chunks;
+        std::atomic<size_t> nextChunk{ 0 };
+        std::atomic<bool> stopped{ false };
+        size_t delivered = 0;
+        size_t window = 0;
+        std::mutex lock;
+        std::condition_variable changed;
+
+        bool WaitForWindow(size_t index)
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return stopped || index < delivered + window; });
+            return !stopped;
+        }
+
+        void MarkReady(size_t index)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            chunks[index].ready = true;
+            changed.notify_all();
+        }
+
+        Chunk& WaitForChunk(size_t index)
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return chunks[index].ready; });
+            return chunks[index];
+        }
+
+        void Release(size_t index)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            std::vector<Match<StringType>>().swap(chunks[index].matches);
+            delivered = index + 1;
+            changed.notify_all();
+        }
+
+        void Stop()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopped = true;
+            changed.notify_all();
+        }
+    };
+
+    template <class StringType, PerformanceStrategy strategy, MatchKind kind>
+    class ScannerImpl
+    {
+    public:
+        typedef typename StringType::value_type ValueType;
+
+        template <class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void Scan(const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback)
+        {
+            if (mPacked.IsEnabled())
+                ScanPacked(callback, begin, end, continueSearchCallback, IsContiguousIterator<InputIt>());
+            else
+            {
+                NoScanStats stats;
+                ScanAutomaton(stats, NoGroupFilter(), callback, begin, end, continueSearchCallback, KindTag());
+            }
+        }
+
+        template <class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void ScanGroups(uint64_t groups, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback)
+        {
+            // without groups every pattern is in group 0
+            if (mPatternGroups.empty() || groups == AllGroups)
+            {
+                if ((groups & 1) != 0)
+                    Scan(callback, begin, end, continueSearchCallback);
+
+                return;
+            }
+
+            NoScanStats stats;
+            ScanAutomaton(stats, GroupFilter{ groups }, callback, begin, end, continueSearchCallback, KindTag());
+        }
+
+        uint64_t GetPatternGroups(size_t index) const noexcept
+        {
+            return mPatternGroups.empty() ? 1 : mPatternGroups[index];
+        }
+
+        template <class MatchCallback>
+        bool ScanFile(const std::string& path, const MatchCallback& callback, size_t bufferSize)
+        {
+#if defined(_WIN32)
+            (void)bufferSize;
+            MappedFile file;
+            if (!file.Open(path, true))
+                return false;
+
+            auto data = (const ValueType*)file.data();
+            Scan(callback, data, data + file.size(), DefaultContinueSearchCallback<const ValueType*>);
+            return true;
+#else
+            int file = open(path.c_str(), O_RDONLY);
+            if (file < 0)
+                return false;
+
+            bool result = ScanFd(file, callback, bufferSize);
+            close(file);
+            return result;
+#endif
+        }
+
+#if !defined(_WIN32)
+        template <class MatchCallback>
+        bool ScanFd(int file, const MatchCallback& callback, size_t bufferSize)
+        {
+            // regular files are scanned in place from the current position (empty ones may be special like procfs)
+            struct stat info;
+            if (fstat(file, &info) != 0)
+                return false;
+
+            off_t position = S_ISREG(info.st_mode) && info.st_size > 0 ? lseek(file, 0, SEEK_CUR) : -1;
+            MappedFile mapped;
+            if (position >= 0 && position <= info.st_size && mapped.Map(file, true))
+            {
+                auto data = (const ValueType*)mapped.data();
+                Scan(callback, data + position, data + mapped.size(), DefaultContinueSearchCallback<const ValueType*>);
+                lseek(file, 0, SEEK_END);
+                return true;
+            }
+
+            // the next buffer is read while the current one is scanned, scanning state is kept between buffers
+            DescriptorReader reader(file, bufferSize);
+            const uint8_t* begin = nullptr;
+            const uint8_t* end = nullptr;
+            if (!reader.Next(begin, end))
+                return !reader.IsFailed();
+
+            Scan(callback, (const ValueType*)begin, (const ValueType*)end, [&reader](const ValueType*& first, const ValueType*& last)
+            {
+                const uint8_t* nextBegin = nullptr;
+                const uint8_t* nextEnd = nullptr;
+                if (!reader.Next(nextBegin, nextEnd))
+                    return false;
+
+                first = (const ValueType*)nextBegin;
+                last = (const ValueType*)nextEnd;
+                return true;
+            });
+
+            return !reader.IsFailed();
+        }
+#endif
+
+        template <class StatsPolicy, class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void ScanWithStats(StatsPolicy& stats, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback)
+        {
+            ScanAutomaton(stats, NoGroupFilter(), callback, begin, end, continueSearchCallback, KindTag());
+        }
+
+        template <class InputIt, class ContinueSearchCallback>
+        void Count(std::vector<size_t>& counts, InputIt begin, InputIt end, ContinueSearchCallback continueSearchCallback)
+        {
+            counts.assign(mCurrentIndex, 0);
+            if (kind != MatchKind::All || mPacked.IsEnabled())
+            {
+                Scan([&counts](const Match<StringType>& m)
+                {
+                    ++counts[m.index];
+                    return true;
+                }, begin, end, continueSearchCallback);
+                return;
+            }
+
+            std::vector<size_t> visits(mNodes.size(), 0);
+            NodeId current = RootNodeId;
+            do
+            {
+                for (InputIt next = begin; next != end; ++next)
+                {
+                    if (current == RootNodeId)
+                    {
+                        mRootFilter.Skip(next, end);
+                        if (next == end)
+                            break;
+                    }
+
+                    current = FindNextCharNode(*next, current);
+                    ++visits[current];
+                }
+            } while (continueSearchCallback(begin, end));
+
+            // every visit of a node is a match of every terminal node in its failure chain, failure links point 
+            // to smaller ids, so reverse order accumulates the whole failure subtree before it is passed further
+            for (size_t id = mNodes.size() - 1; id > RootNodeId; --id)
+            {
+                const auto& node = mNodes[id];
+                visits[node.failureLink] += visits[id];
+                if (node.matchIndex != NodeType::InvalidMatchIndex)
+                    counts[node.matchIndex] = visits[id];
+            }
+        }
+
+        template <class InputIt, class MatchCallback>
+        bool Scan(ScanState& state, InputIt begin, InputIt end, const MatchCallback& callback)
+        {
+            size_t offset = (size_t)state.offset;
+            NoScanStats stats;
+            bool completed = ScanBuffer(stats, NoGroupFilter(), state.node, offset, state.pendingMatch, begin, end, callback);
+            state.offset = offset;
+            return completed;
+        }
+
+        template <class InputIt>
+        size_t ScanRecords(ScanState& state, InputIt& begin, InputIt end, MatchRecord* records, size_t capacity)
+        {
+            if (capacity == 0)
+                return 0;
+
+            // appending is inlined into the output chain walk, scanning stops once the buffer is full
+            size_t count = 0;
+            size_t offset = (size_t)state.offset;
+            NoScanStats stats;
+            ScanBuffer(stats, NoGroupFilter(), state.node, offset, state.pendingMatch, begin, end, 
+                [records, capacity, &count](const Match<StringType>& m)
+                {
+                    records[count] = MatchRecord{ m.offset + m.length, (uint32_t)m.index, (uint32_t)m.length };
+                    return ++count != capacity;
+                });
+
+            state.offset = offset;
+            return count;
+        }
+
+        template <class RangeIt, class MatchCallback>
+        void ScanBatch(RangeIt first, RangeIt last, const MatchCallback& callback)
+        {
+            ScanBatch(first, last, callback, std::integral_constant<bool, kind == MatchKind::All || kind == MatchKind::Existence>());
+        }
+
+        template <class RangeIt, class MatchCallback>
+        void ScanBatch(RangeIt first, RangeIt last, const MatchCallback& callback, std::false_type)
+        {
+            for (size_t stream = 0; first != last; ++first, ++stream)
+            {
+                Scan([&callback, stream](const Match<StringType>& m)
+                {
+                    return callback(stream, m);
+                }, first->first, first->second, DefaultContinueSearchCallback<std::decay_t<decltype(first->first)>>);
+            }
+        }
+
+        template <class RangeIt, class MatchCallback>
+        void ScanBatch(RangeIt first, RangeIt last, const MatchCallback& callback, std::true_type)
+        {
+            typedef std::decay_t<decltype(first->first)> InputIt;
+            struct Lane
+            {
+                InputIt next;
+                InputIt end;
+                size_t offset;
+                size_t stream;
+                NodeId current;
+            };
+
+            std::array<Lane, BatchLaneCount> lanes;
+            size_t laneCount = 0;
+            size_t streamCount = 0;
+            for (; first != last && laneCount < BatchLaneCount; ++first)
+                lanes[laneCount++] = Lane{ first->first, first->second, 0, streamCount++, RootNodeId };
+
+            while (laneCount > 0)
+            {
+                // every lane makes one step per round, the next transition of each one is prefetched while the others work
+                for (size_t i = 0; i < laneCount; )
+                {
+                    auto& lane = lanes[i];
+                    if (lane.next == lane.end)
+                    {
+                        if (first != last)
+                        {
+                            lane = Lane{ first->first, first->second, 0, streamCount++, RootNodeId };
+                            ++first;
+                        }
+                        else
+                            lane = lanes[--laneCount];
+
+                        continue;
+                    }
+
+                    if (lane.current == RootNodeId)
+                    {
+                        lane.offset += mRootFilter.Skip(lane.next, lane.end);
+                        if (lane.next == lane.end)
+                            continue;
+                    }
+
+                    lane.current = FindNextCharNode(*lane.next, lane.current);
+                    ++lane.next;
+                    ++lane.offset;
+                    if (lane.current != RootNodeId)
+                    {
+                        NodeId pending = InvalidNodeId;
+                        size_t stream = lane.stream;
+                        if (!ReportChain(lane.current, lane.offset, pending, [&callback, stream](const Match<StringType>& m)
+                            {
+                                return callback(stream, m);
+                            }))
+                        {
+                            lane.next = lane.end;
+                            continue;
+                        }
+                    }
+
+                    if (lane.next != lane.end)
+                        Prefetch(lane.current, *lane.next);
+
+                    ++i;
+                }
+            }
+        }
+
+        ScannerEngine GetEngine() const noexcept 
+        { 
+            return mPacked.IsEnabled() ? ScannerEngine::PackedSimd : ScannerEngine::Automaton; 
+        }
+
+        AutomatonStats GetAutomatonStats() const
+        {
+            AutomatonStats stats;
+            size_t count = mNodes.size();
+            stats.nodeCount = count;
+            stats.patternCount = mCurrentIndex;
+            stats.nodeBytes = count * sizeof(NodeType);
+            stats.childrenBytes = mChildren.GetMemoryUsage();
+            stats.auxiliaryBytes = sizeof(mRootFilter) + mRootPairs.GetMemoryUsage() + sizeof(mNormalizer) + mPacked.GetMemoryUsage()
+                + (mPatternGroups.size() + mChainGroups.size()) * sizeof(uint64_t);
+            stats.patternBytes = mWords.capacity() * sizeof(StringType);
+            for (const auto& word : mWords)
+                stats.patternBytes += word.size() * sizeof(ValueType);
+
+            std::vector<ValueType> values;
+            values.reserve(count);
+            // failure and output links point to smaller ids, so chains are computed from the ones already known
+            std::vector<uint32_t> failureChains(count, 0);
+            std::vector<uint32_t> outputChains(count, 0);
+            uint64_t failureTotal = 0;
+            uint64_t outputTotal = 0;
+            for (size_t id = 0; id < count; ++id)
+            {
+                const auto& node = mNodes[id];
+                if (stats.fanouts.size() <= node.childCount)
+                    stats.fanouts.resize(node.childCount + 1, 0);
+
+                if (stats.depths.size() <= node.depth)
+                    stats.depths.resize(node.depth + 1, 0);
+
+                ++stats.fanouts[node.childCount];
+                ++stats.depths[node.depth];
+                if (id == RootNodeId)
+                    continue;
+
+                values.push_back(node.value);
+                failureChains[id] = failureChains[node.failureLink] + 1;
+                outputChains[id] = (node.matchIndex != NodeType::InvalidMatchIndex ? 1 : 0) 
+                    + (node.nextMatchLink != InvalidNodeId ? outputChains[node.nextMatchLink] : 0);
+
+                stats.maxFailureChain = std::max<size_t>(stats.maxFailureChain, failureChains[id]);
+                stats.maxOutputChain = std::max<size_t>(stats.maxOutputChain, outputChains[id]);
+                failureTotal += failureChains[id];
+                outputTotal += outputChains[id];
+            }
+
+            std::sort(values.begin(), values.end());
+            stats.alphabetSize = std::unique(values.begin(), values.end()) - values.begin();
+            stats.averageFailureChain = (double)failureTotal / count;
+            stats.averageOutputChain = (double)outputTotal / count;
+            return stats;
+        }
+
+        template <class MatchCallback, class RandomIt>
+        void ScanParallel(const MatchCallback& callback, RandomIt begin, RandomIt end, const ParallelScanOptions& options)
+        {
+            size_t size = end - begin;
+            size_t threadCount = options.threadCount != 0 ? options.threadCount : std::thread::hardware_concurrency();
+            threadCount = std::max<size_t>(threadCount, 1);
+            size_t overlap = mMaxWordLength > 0 ? mMaxWordLength - 1 : 0;
+            size_t chunkSize = options.chunkSize;
+            if (chunkSize == 0)
+                chunkSize = std::max<size_t>(size / (threadCount * 4) + 1, std::max<size_t>(overlap * 16, 64 * 1024));
+
+            size_t chunkCount = (size + chunkSize - 1) / chunkSize;
+            if (kind != MatchKind::All || threadCount == 1 || chunkCount <= 1)
+            {
+                Scan(callback, begin, end, DefaultContinueSearchCallback<RandomIt>);
+                return;
+            }
+
+            threadCount = std::min(threadCount, chunkCount);
+            ParallelScanContext<StringType> context;
+            context.chunks.resize(chunkCount);
+            // ordered delivery keeps only a limited amount of chunks ahead of the consumer
+            context.window = options.ordered ? threadCount * 2 : chunkCount;
+
+            auto worker = [&]()
+            {
+                for (;;)
+                {
+                    size_t index = context.nextChunk++;
+                    if (index >= chunkCount || !context.WaitForWindow(index))
+                        return;
+
+                    size_t chunkBegin = index * chunkSize;
+                    size_t chunkEnd = std::min(chunkBegin + chunkSize, size);
+                    size_t scanBegin = chunkBegin > overlap ? chunkBegin - overlap : 0;
+                    auto& chunk = context.chunks[index];
+                    Scan([&](const Match<StringType>& m)
+                    {
+                        size_t offset = scanBegin + m.offset;
+                        // matches ending inside the overlap belong to the previous chunk
+                        if (offset + m.length <= chunkBegin)
+                            return !context.stopped;
+
+                        Match<StringType> shifted{ offset, m.index, m.word, m.length };
+                        if (options.ordered)
+                        {
+                            chunk.matches.push_back(shifted);
+                            return !context.stopped;
+                        }
+
+                        if (context.stopped || !callback(shifted))
+                        {
+                            context.stopped = true;
+                            return false;
+                        }
+
+                        return true;
+                    }, begin + scanBegin, begin + chunkEnd, DefaultContinueSearchCallback<RandomIt>);
+
+                    context.MarkReady(index);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+            for (size_t i = 0; i < threadCount; ++i)
+                threads.emplace_back(worker);
+
+            if (options.ordered)
+            {
+                for (size_t index = 0; index < chunkCount && !context.stopped; ++index)
+                {
+                    auto& chunk = context.WaitForChunk(index);
+                    for (const auto& m : chunk.matches)
+                    {
+                        if (!callback(m))
+                        {
+                            context.Stop();
+                            break;
+                        }
+                    }
+
+                    context.Release(index);
+                }
+            }
+
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        template <class WordIt>
+        ScannerImpl(WordIt begin, WordIt end, const ScannerOptions& options) : mCurrentIndex(0), mMaxWordLength(0)
+        {
+            mNormalizer.Build(options);
+            TrieBuilder<ValueType, StringType> builder(options.memoryResource);
+            size_t threadCount = GetBuildThreadCount(options);
+            if (threadCount > 1)
+                BuildTrie(builder, begin, end, threadCount);
+            else
+            {
+                for (WordIt it = begin; it < end; ++it)
+                {
+                    if (builder.AddWord(*it, mCurrentIndex, mNormalizer))
+                    {
+                        mWords.push_back(*it);
+                        ++mCurrentIndex;
+                        mMaxWordLength = std::max<size_t>(mMaxWordLength, (*it).size());
+                    }
+                }
+            }
+
+            if (!options.groups.empty())
+                AssignGroups(builder, begin, end, options.groups);
+
+            Build(builder, options);
+        }
+
+        /**
+         * \brief Builds automaton from a trie kept by updatable scanner, words are indexed by match index (removed ones are empty).
+         */
+        ScannerImpl(const TrieBuilder<ValueType, StringType>& builder, const std::vector<StringType>& words,
+            const ScannerOptions& options) : mWords(words), mCurrentIndex(words.size()), mMaxWordLength(0)
+        {
+            mNormalizer.Build(options);
+            for (const auto& word : mWords)
+                mMaxWordLength = std::max<size_t>(mMaxWordLength, word.size());
+
+            Build(builder, options);
+        }
+
+        /**
+         * \brief Writes automaton in position independent binary format, see Scanner::Save.
+         */
+        bool Save(std::ostream& stream) const
+        {
+            static_assert(std::numeric_limits<ValueType>::is_integer, "only integer 'characters' can be saved");
+
+            FileHeader header = MakeHeader();
+            header.patternCount = mCurrentIndex;
+            header.maxWordLength = mMaxWordLength;
+
+            BinaryWriter writer(stream);
+            writer.WriteRaw(&header, sizeof(header));
+            writer.WriteSection(mNodes.data(), mNodes.size());
+            mChildren.Save(writer);
+            mRootFilter.Save(writer);
+            mRootPairs.Save(writer);
+            mNormalizer.Save(writer);
+            writer.WriteSection(mPatternGroups.data(), mPatternGroups.size());
+            writer.WriteSection(mChainGroups.data(), mChainGroups.size());
+            return writer.IsGood();
+        }
+
+        /**
+         * \brief Maps automaton file, see Scanner::Load.
+         */
+        static std::unique_ptr<ScannerImpl> Load(const std::string& path)
+        {
+            static_assert(std::numeric_limits<ValueType>::is_integer, "only integer 'characters' can be loaded");
+
+            std::unique_ptr<ScannerImpl> result(new ScannerImpl());
+            if (!result->mFile.Open(path))
+                return nullptr;
+
+            FileHeader expected = MakeHeader();
+            FileHeader header;
+            BinaryReader reader(result->mFile.data(), result->mFile.size());
+            if (!reader.ReadRaw(&header, sizeof(header)) || !std::equal(std::begin(header.magic), std::end(header.magic), 
+                std::begin(expected.magic)) || header.version != expected.version || header.byteOrder != expected.byteOrder
+                || header.valueSize != expected.valueSize || header.valueSigned != expected.valueSigned 
+                || header.strategyId != expected.strategyId || header.nodeSize != expected.nodeSize)
+                return nullptr;
+
+            if (!reader.ReadArray(result->mNodes) || result->mNodes.empty() || !result->ValidateNodes(header.patternCount)
+                || !result->mChildren.Load(reader, result->mNodes.size()) || !result->mRootFilter.Load(reader)
+                || !result->mRootPairs.Load(reader, result->mNodes.size()) || !result->mNormalizer.Load(reader)
+                || !reader.ReadArray(result->mPatternGroups) || !reader.ReadArray(result->mChainGroups)
+                || !result->ValidateGroups(header.patternCount))
+                return nullptr;
+
+            result->mCurrentIndex = (size_t)header.patternCount;
+            result->mMaxWordLength = (size_t)header.maxWordLength;
+            return result;
+        }
+
+    private:
+        typedef TrieNode<ValueType> NodeType;
+        typedef std::integral_constant<PerformanceStrategy, strategy> StrategyTag;
+        typedef std::integral_constant<PerformanceStrategy, PerformanceStrategy::Dfa> DfaTag;
+        typedef std::integral_constant<MatchKind, kind> KindTag;
+        typedef std::integral_constant<MatchKind, MatchKind::LeftmostFirst> LeftmostFirstTag;
+        typedef std::integral_constant<MatchKind, MatchKind::LeftmostLongest> LeftmostLongestTag;
+
+        /**
+         * \brief Automaton file header, file is rejected if anything but counters differs from the expected one.
+         */
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t valueSize;
+            uint32_t valueSigned;
+            uint32_t strategyId;
+            uint32_t nodeSize;
+            uint64_t patternCount;
+            uint64_t maxWordLength;
+        };
+
+        static const uint32_t FileVersion = 5;
+
+        static FileHeader MakeHeader() noexcept
+        {
+            FileHeader header = { { 'A', 'H', 'O', 'C', 'O', 'R', 'A', 'S' }, FileVersion, 0x01020304, sizeof(ValueType), 
+                std::numeric_limits<ValueType>::is_signed ? 1u : 0u, (uint32_t)strategy, sizeof(NodeType), 0, 0 };
+            return header;
+        }
+
+        // amount of streams advanced in lockstep by ScanBatch, enough to cover memory latency with a few independent misses
+        static const size_t BatchLaneCount = 8;
+        // BFS levels smaller than this are not worth starting threads
+        static const size_t MinParallelLevelSize = 16 * 1024;
+
+        ScannerImpl() noexcept : mCurrentIndex(0), mMaxWordLength(0) {}
+
+        static size_t GetBuildThreadCount(const ScannerOptions& options) noexcept
+        {
+            size_t threadCount = options.buildThreadCount != 0 ? options.buildThreadCount : std::thread::hardware_concurrency();
+            return std::max<size_t>(threadCount, 1);
+        }
+
+        /**
+         * \brief Builds subtries of patterns with different leading 'characters' concurrently and merges them, match indices 
+         * are the same as sequential insertion assigns.
+         */
+        template <class WordIt>
+        void BuildTrie(TrieBuilder<ValueType, StringType>& builder, WordIt begin, WordIt end, size_t threadCount)
+        {
+            size_t count = end - begin;
+            std::map<ValueType, size_t> leading;
+            for (WordIt it = begin; it < end; ++it)
+            {
+                if (!(*it).empty())
+                    ++leading[mNormalizer(*(*it).begin())];
+            }
+
+            // every leading 'character' goes to the least loaded part, the most popular ones first
+            std::vector<std::pair<size_t, ValueType>> symbols;
+            for (const auto& symbol : leading)
+                symbols.emplace_back(symbol.second, symbol.first);
+
+            std::sort(symbols.begin(), symbols.end(), [](const std::pair<size_t, ValueType>& lhs, const std::pair<size_t, ValueType>& rhs)
+            {
+                return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+            });
+
+            threadCount = std::min(threadCount, symbols.size());
+            std::vector<size_t> loads(threadCount, 0);
+            for (const auto& symbol : symbols)
+            {
+                size_t part = std::min_element(loads.begin(), loads.end()) - loads.begin();
+                loads[part] += symbol.first;
+                leading[symbol.second] = part;
+            }
+
+            std::vector<std::vector<size_t>> positions(threadCount);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto& word = begin[i];
+                if (!word.empty())
+                    positions[leading[mNormalizer(*word.begin())]].push_back(i);
+            }
+
+            // parts use positions as match indices, duplicates are rejected by the part holding the first occurrence
+            std::vector<TrieBuilder<ValueType, StringType>> parts(threadCount);
+            std::vector<uint8_t> accepted(count, 0);
+            ParallelFor(threadCount, threadCount, [this, &parts, &positions, &accepted, begin](size_t first, size_t last)
+            {
+                for (size_t part = first; part < last; ++part)
+                {
+                    for (size_t position : positions[part])
+                        accepted[position] = parts[part].AddWord(begin[position], position, mNormalizer) ? 1 : 0;
+                }
+            });
+
+            std::vector<uint32_t> indices(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (accepted[i] != 0)
+                {
+                    indices[i] = (uint32_t)mCurrentIndex++;
+                    mWords.push_back(begin[i]);
+                    mMaxWordLength = std::max<size_t>(mMaxWordLength, begin[i].size());
+                }
+            }
+
+            builder.Merge(parts, indices, threadCount);
+        }
+
+        /**
+         * \brief Collects group mask of every pattern, duplicates share match index, so its mask has groups of all of them.
+         */
+        template <class WordIt>
+        void AssignGroups(const TrieBuilder<ValueType, StringType>& builder, WordIt begin, WordIt end, 
+            const std::vector<uint8_t>& groups)
+        {
+            std::vector<uint64_t> masks(mCurrentIndex, 0);
+            size_t position = 0;
+            for (WordIt it = begin; it < end; ++it, ++position)
+            {
+                uint32_t index = builder.FindWord(*it, mNormalizer);
+                size_t group = position < groups.size() ? groups[position] : 0;
+                if (index != NodeType::InvalidMatchIndex && group < MaxGroupCount)
+                    masks[index] |= (uint64_t)1 << group;
+            }
+
+            mPatternGroups.Assign(std::move(masks));
+        }
+
+        /**
+         * \brief Calls function(first, last) for ranges of every BFS level in order, large levels are split between threads.
+         */
+        template <class Function>
+        static void ForEachLevel(const std::vector<NodeType>& nodes, size_t threadCount, const Function& function)
+        {
+            for (size_t first = 1; first < nodes.size();)
+            {
+                size_t last = first;
+                while (last < nodes.size() && nodes[last].depth == nodes[first].depth)
+                    ++last;
+
+                if (threadCount > 1 && last - first >= MinParallelLevelSize)
+                    ParallelFor(threadCount, last - first, [&function, first](size_t begin, size_t end) { function(first + begin, first + end); });
+                else
+                    function(first, last);
+
+                first = last;
+            }
+        }
+
+        void Build(const TrieBuilder<ValueType, StringType>& builder, const ScannerOptions& options)
+        {
+            std::vector<NodeType> nodes;
+            builder.Flatten(nodes);
+            mChildren.Build(nodes);
+            mChildren.ApplyNormalization(mNormalizer);
+            mRootFilter.Build(nodes, mNormalizer);
+            // packed engine reports all matches only and matches input as is
+            bool packedApplicable = kind == MatchKind::All && !mNormalizer.IsEnabled();
+            mPacked.Build(nodes, mWords, packedApplicable ? options.engine : ScannerEngine::Automaton);
+
+            BuildLinks(nodes, GetBuildThreadCount(options));
+            mNodes.Assign(std::move(nodes));
+            if (options.rootPairTable)
+                mRootPairs.Build(mNodes, [this](NodeId parent, const ValueType& chr) { return FindNextCharNode(chr, parent); });
+
+            if (mPatternGroups.empty())
+                return;
+
+            // output links point to smaller ids, so the rest of every chain is already known
+            std::vector<uint64_t> chainGroups(mNodes.size(), 0);
+            for (size_t id = RootNodeId + 1; id < mNodes.size(); ++id)
+            {
+                const auto& node = mNodes[id];
+                if (node.matchIndex != NodeType::InvalidMatchIndex)
+                    chainGroups[id] = mPatternGroups[node.matchIndex];
+
+                if (node.nextMatchLink != InvalidNodeId)
+                    chainGroups[id] |= chainGroups[node.nextMatchLink];
+            }
+
+            mChainGroups.Assign(std::move(chainGroups));
+        }
+
+        bool ValidateNodes(uint64_t patternCount) const noexcept
+        {
+            // all links must stay inside node storage, otherwise corrupted file could make scanning read out of bounds;
+            // parent, failure and output links always point to shallower nodes, i.e. to smaller ids (no cycles)
+            size_t count = mNodes.size();
+            const auto& root = mNodes[RootNodeId];
+            if (root.failureLink != InvalidNodeId || root.parentLink != InvalidNodeId || root.depth != 0)
+                return false;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto& node = mNodes[i];
+                if ((i != RootNodeId && (node.failureLink >= i || node.parentLink >= i || node.depth != mNodes[node.parentLink].depth + 1))
+                    || (node.nextMatchLink != InvalidNodeId && node.nextMatchLink >= i)
+                    || (node.childCount != 0 && (uint64_t)node.firstChild + node.childCount > count)
+                    || (node.matchIndex != NodeType::InvalidMatchIndex && node.matchIndex >= patternCount))
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool ValidateGroups(uint64_t patternCount) const noexcept
+        {
+            // both are either empty or have an entry per pattern and per node
+            if (mPatternGroups.empty() && mChainGroups.empty())
+                return true;
+
+            return mPatternGroups.size() == patternCount && mChainGroups.size() == mNodes.size();
+        }
+
+        MappedFile mFile;
+        FlatArray<NodeType> mNodes;
+        // patterns indexed by match index, empty for loaded scanners
+        std::vector<StringType> mWords;
+        NodeChildren<ValueType, StringType, strategy> mChildren;
+        RootFilter<ValueType> mRootFilter;
+        RootPairTable<ValueType> mRootPairs;
+        Normalizer<ValueType> mNormalizer;
+        // group mask of every pattern and union of masks of every node output chain, empty if groups are not used
+        FlatArray<uint64_t> mPatternGroups;
+        FlatArray<uint64_t> mChainGroups;
+        PackedMatcher<StringType> mPacked;
+        size_t mCurrentIndex;
+        size_t mMaxWordLength;
 
         template <class MatchCallback, class InputIt, class ContinueSearchCallback>
-        void Scan(const MatchCallback& callback, InputIt begin, InputIt end, 
-            ContinueSearchCallback continueSearchCallback)
+        void ScanPacked(const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback, std::true_type)
+        {
+            mPacked.Scan(callback, begin, end, continueSearchCallback);
+        }
+
+        template <class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void ScanPacked(const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback, std::false_type)
+        {
+            NoScanStats stats;
+            ScanAutomaton(stats, NoGroupFilter(), callback, begin, end, continueSearchCallback, KindTag());
+        }
+
+        /**
+         * \brief Group filter of regular scans, masks are never checked.
+         */
+        struct NoGroupFilter
+        {
+            static const bool Enabled = false;
+            uint64_t groups = AllGroups;
+        };
+
+        /**
+         * \brief Group filter of Scanner::ScanGroups, it is a separate instantiation of the scanning loop.
+         */
+        struct GroupFilter
+        {
+            static const bool Enabled = true;
+            uint64_t groups;
+        };
+
+        template <class StatsPolicy, class FilterType, class MatchCallback, class InputIt, class ContinueSearchCallback, class Tag>
+        void ScanAutomaton(StatsPolicy& stats, const FilterType& filter, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback, Tag)
+        {
+            NodeId current = RootNodeId;
+            NodeId pending = InvalidNodeId;
+            size_t offset = 0;
+            do
+            {
+                // continuation callback receives the buffer scanned
+                InputIt position = begin;
+                if (!ScanBuffer(stats, filter, current, offset, pending, position, end, callback))
+                    return;
+            } while (continueSearchCallback(begin, end));
+        }
+
+        template <class StatsPolicy, class FilterType, class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void ScanAutomaton(StatsPolicy& stats, const FilterType& filter, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback, LeftmostFirstTag)
+        {
+            ScanLeftmost(stats, filter.groups, callback, begin, end, continueSearchCallback);
+        }
+
+        template <class StatsPolicy, class FilterType, class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void ScanAutomaton(StatsPolicy& stats, const FilterType& filter, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback, LeftmostLongestTag)
+        {
+            ScanLeftmost(stats, filter.groups, callback, begin, end, continueSearchCallback);
+        }
+
+        /**
+         * \brief State of leftmost scanning: match found is kept as a candidate until no better one can appear.
+         */
+        struct LeftmostContext
         {
-            NodeType* current = &mRoot;
+            NodeId current = RootNodeId;
             size_t offset = 0;
+            // terminal node of the candidate
+            NodeId candidate = InvalidNodeId;
+            size_t candidateStart = 0;
+            // input since the candidate start, the part after the candidate end is scanned again once it is reported
+            std::vector<ValueType> history;
+            // patterns of other groups are not candidates
+            uint64_t groups = AllGroups;
+        };
+
+        template <class StatsPolicy, class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void ScanLeftmost(StatsPolicy& stats, uint64_t groups, const MatchCallback& callback, InputIt begin, InputIt end, 
+            ContinueSearchCallback continueSearchCallback)
+        {
+            LeftmostContext context;
+            context.groups = groups;
             do
             {
-                for (InputIt next = begin; next != end; ++next, ++offset)
+                for (InputIt next = begin; next != end; ++next)
                 {
-                    current = FindNextCharNode(*next, current);
-                    if (current == nullptr)
+                    if (context.current == RootNodeId && context.candidate == InvalidNodeId)
                     {
-                        current = &mRoot;
-                        continue;
+                        size_t skipped = mRootFilter.Skip(next, end);
+                        stats.OnSkip(skipped);
+                        context.offset += skipped;
+                        if (next == end)
+                            break;
                     }
 
-                    auto matchNode = current;
-                    do
-                    {
-                        if (!matchNode->word.empty())
-                        {
-                            Match<StringType> m{ offset + 1 - matchNode->word.size(), matchNode->matchIndex, &matchNode->word };
-                            if (!callback(m))
-                                return;
-                        }
-
-                        matchNode = matchNode->nextMatchLink;
-                    } while (matchNode != nullptr);
+                    if (!StepLeftmost(stats, context, *next, callback))
+                        return;
                 }
             } while (continueSearchCallback(begin, end));
+
+            while (context.candidate != InvalidNodeId)
+            {
+                if (!ReportLeftmost(stats, context, callback))
+                    return;
+            }
         }
 
-        template <class WordIt>
-        ScannerImpl(WordIt begin, WordIt end) : mCurrentIndex(0)
+        /**
+         * \brief Feeds 'character' to the automaton, reports the candidate when a better match becomes impossible.
+         *
+         * \return false if callback requested to stop
+         */
+        template <class StatsPolicy, class MatchCallback>
+        bool StepLeftmost(StatsPolicy& stats, LeftmostContext& context, const ValueType& chr, const MatchCallback& callback)
         {
-            for (WordIt it = begin; it < end; ++it)
-                AddWord(*it);
+            if (context.candidate != InvalidNodeId)
+                context.history.push_back(chr);
 
-            BuildLinks();
+            context.current = FindNextCharNode(chr, context.current, stats);
+            ++context.offset;
+            const auto& node = mNodes[context.current];
+            stats.OnSymbol(node.depth);
+            // any match starting not later than the candidate requires the current path to start not later than it
+            if (context.candidate != InvalidNodeId && node.depth < context.offset - context.candidateStart)
+                return ReportLeftmost(stats, context, callback);
+
+            // matches of the chain end at the same position, so the first (longest) one starts first
+            NodeId matchNode = GetFirstMatch(context.current, context.groups);
+            if (matchNode == InvalidNodeId)
+                return true;
+
+            stats.OnChainStep();
+            const auto& match = mNodes[matchNode];
+            size_t start = context.offset - match.depth;
+            if (context.candidate == InvalidNodeId || start < context.candidateStart)
+            {
+                // input since the match start is the pattern itself
+                context.history.resize(match.depth);
+                NodeId id = matchNode;
+                for (size_t i = match.depth; i > 0; --i, id = mNodes[id].parentLink)
+                    context.history[i - 1] = mNodes[id].value;
+
+                context.candidate = matchNode;
+                context.candidateStart = start;
+            }
+            else if (start == context.candidateStart && (kind == MatchKind::LeftmostLongest 
+                || match.matchIndex < mNodes[context.candidate].matchIndex))
+                context.candidate = matchNode;
+
+            return true;
         }
 
-    private:
-        typedef TrieNode<ValueType, StringType, strategy> NodeType;
-        NodeType mRoot;
-        size_t mCurrentIndex;
+        /**
+         * \brief Reports the candidate and rescans input after its end, matches starting there were ignored meanwhile.
+         *
+         * \return false if callback requested to stop
+         */
+        template <class StatsPolicy, class MatchCallback>
+        bool ReportLeftmost(StatsPolicy& stats, LeftmostContext& context, const MatchCallback& callback)
+        {
+            const auto& node = mNodes[context.candidate];
+            auto word = mWords.empty() ? nullptr : &mWords[node.matchIndex];
+            Match<StringType> m{ context.candidateStart, node.matchIndex, word, node.depth };
+            stats.OnCallback();
+            if (!callback(m))
+                return false;
+
+            std::vector<ValueType> tail(context.history.begin() + node.depth, context.history.end());
+            context.offset = context.candidateStart + node.depth;
+            context.current = RootNodeId;
+            context.candidate = InvalidNodeId;
+            context.history.clear();
+            for (const auto& chr : tail)
+            {
+                if (!StepLeftmost(stats, context, chr, callback))
+                    return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * \brief Returns the first node of the output chain reporting a pattern of the groups selected, InvalidNodeId if none.
+         */
+        NodeId GetFirstMatch(NodeId id, uint64_t groups) const noexcept
+        {
+            const auto& node = mNodes[id];
+            NodeId matchNode = node.matchIndex != NodeType::InvalidMatchIndex ? id : node.nextMatchLink;
+            if (groups == AllGroups)
+                return matchNode;
 
-        NodeType* FindNextCharNode(const ValueType& chr, NodeType* parent)
+            while (matchNode != InvalidNodeId && (mPatternGroups[mNodes[matchNode].matchIndex] & groups) == 0)
+            {
+                if ((mChainGroups[matchNode] & groups) == 0)
+                    return InvalidNodeId;
+
+                matchNode = mNodes[matchNode].nextMatchLink;
+            }
+
+            return matchNode;
+        }
+
+        /**
+         * \brief Reports output chain starting from the node provided, the last 'character' matched is at offset - 1.
+         *
+         * \return false if callback requested to stop, pending is set to the next chain node not reported yet
+         */
+        template <class MatchCallback>
+        bool ReportChain(NodeId matchNode, size_t offset, NodeId& pending, const MatchCallback& callback)
+        {
+            NoScanStats stats;
+            return ReportChain(stats, NoGroupFilter(), matchNode, offset, pending, callback);
+        }
+
+        template <class StatsPolicy, class FilterType, class MatchCallback>
+        bool ReportChain(StatsPolicy& stats, const FilterType& filter, NodeId matchNode, size_t offset, NodeId& pending, 
+            const MatchCallback& callback)
         {
-            NodeType* result = parent;
-            while (result != nullptr)
+            do
             {
-                NodeType* nextLink = result->children.TryGet(chr);
-                if (nextLink != nullptr)
+                // the rest of the chain has no pattern of the groups selected
+                if (FilterType::Enabled && (mChainGroups[matchNode] & filter.groups) == 0)
+                    return true;
+
+                const auto& node = mNodes[matchNode];
+                matchNode = node.nextMatchLink;
+                stats.OnChainStep();
+                if (node.matchIndex != NodeType::InvalidMatchIndex 
+                    && (!FilterType::Enabled || (mPatternGroups[node.matchIndex] & filter.groups) != 0))
                 {
-                    result = nextLink;
-                    break;
+                    auto word = mWords.empty() ? nullptr : &mWords[node.matchIndex];
+                    Match<StringType> m{ offset - node.depth, node.matchIndex, word, node.depth };
+                    stats.OnCallback();
+                    if (!callback(m))
+                    {
+                        pending = matchNode;
+                        return false;
+                    }
+
+                    // the first match of the chain is the longest one of those ending first
+                    if (kind == MatchKind::Existence)
+                        return false;
                 }
+            } while (matchNode != InvalidNodeId);
+
+            return true;
+        }
 
-                result = result->failureLink;
+        /**
+         * \brief Feeds buffer to the automaton starting from the current node, pending output chain is reported first.
+         *
+         * \return false if callback requested to stop, begin, current and offset point right after the last 'character' 
+         * processed
+         */
+        template <class StatsPolicy, class FilterType, class MatchCallback, class InputIt>
+        bool ScanBuffer(StatsPolicy& stats, const FilterType& filter, NodeId& current, size_t& offset, NodeId& pending, 
+            InputIt& begin, InputIt end, const MatchCallback& callback)
+        {
+            if (pending != InvalidNodeId)
+            {
+                NodeId chain = pending;
+                pending = InvalidNodeId;
+                if (!ReportChain(stats, filter, chain, offset, pending, callback))
+                    return false;
             }
 
-            return result;
+            InputIt next = begin;
+            for (; next != end; ++next, ++offset)
+            {
+                bool paired = false;
+                if (current == RootNodeId)
+                {
+                    size_t skipped = mRootFilter.Skip(next, end);
+                    stats.OnSkip(skipped);
+                    offset += skipped;
+                    if (next == end)
+                        break;
+
+                    paired = StepRootPair(stats, current, offset, next, end, typename std::iterator_traits<InputIt>::iterator_category());
+                }
+
+                if (!paired)
+                    current = FindNextCharNode(*next, current, stats);
+                // depth costs a node access Dfa transitions don't need otherwise
+                if (StatsPolicy::Enabled)
+                    stats.OnSymbol(mNodes[current].depth);
+
+                if (current == RootNodeId)
+                    continue;
+
+                if (!ReportChain(stats, filter, current, offset + 1, pending, callback))
+                {
+                    begin = ++next;
+                    ++offset;
+                    return false;
+                }
+            }
+
+            begin = next;
+            return true;
+        }
+
+        /**
+         * \brief Moves from root by two 'characters' at once using the root pair table.
+         *
+         * \return false if the pair can't be consumed at once (table is disabled, single 'character' left or the first 
+         * one reports matches), otherwise next points to the second 'character' and offset is advanced by one
+         */
+        template <class StatsPolicy, class InputIt>
+        bool StepRootPair(StatsPolicy& stats, NodeId& current, size_t& offset, InputIt& next, const InputIt& end, 
+            std::forward_iterator_tag)
+        {
+            if (!mRootPairs.IsEnabled())
+                return false;
+
+            InputIt second = std::next(next);
+            if (second == end)
+                return false;
+
+            NodeId result = mRootPairs.Get(*next, *second);
+            if (result == InvalidNodeId)
+                return false;
+
+            // root has no failure link, so the first transition is a single lookup
+            if (StatsPolicy::Enabled)
+                stats.OnSymbol(mNodes[FindNextCharNode(*next, RootNodeId)].depth);
+
+            current = result;
+            next = second;
+            ++offset;
+            return true;
+        }
+
+        // single pass input can't be read ahead
+        template <class StatsPolicy, class InputIt>
+        bool StepRootPair(StatsPolicy&, NodeId&, size_t&, InputIt&, const InputIt&, std::input_iterator_tag) noexcept
+        {
+            return false;
+        }
+
+        void Prefetch(NodeId current, const ValueType& chr) const noexcept
+        {
+            // Dfa transition doesn't touch the node itself
+            if (strategy != PerformanceStrategy::Dfa)
+                PrefetchRead(mNodes.data() + current);
+
+            mChildren.Prefetch(current, chr);
+        }
+
+        NodeId FindNextCharNode(const ValueType& chr, NodeId parent)
+        {
+            NoScanStats stats;
+            return FindNextCharNode(chr, parent, stats, StrategyTag());
+        }
+
+        template <class StatsPolicy>
+        NodeId FindNextCharNode(const ValueType& chr, NodeId parent, StatsPolicy& stats)
+        {
+            return FindNextCharNode(chr, parent, stats, StrategyTag());
+        }
+
+        template <class StatsPolicy>
+        NodeId FindNextCharNode(const ValueType& chr, NodeId parent, StatsPolicy&, DfaTag) noexcept
+        {
+            return mChildren.GetTransition(parent, chr);
+        }
+
+        template <class StatsPolicy, class Tag>
+        NodeId FindNextCharNode(const ValueType& chr, NodeId parent, StatsPolicy& stats, Tag)
+        {
+            // table based strategies have normalization folded into their class map
+            const bool normalize = strategy != PerformanceStrategy::MaximumPerformance && mNormalizer.IsEnabled();
+            ValueType value = normalize ? mNormalizer(chr) : chr;
+            NodeId result = parent;
+            while (result != InvalidNodeId)
+            {
+                NodeId nextLink = mChildren.TryGet(mNodes[result], result, value);
+                if (nextLink != RootNodeId)
+                    return nextLink;
+
+                result = mNodes[result].failureLink;
+                if (result != InvalidNodeId)
+                    stats.OnFailureHop();
+            }
+
+            return RootNodeId;
         }
 
-        void BuildChildLink(NodeType* child)
+        void BuildChildLink(std::vector<NodeType>& nodes, NodeId childId)
         {
-            auto chr = child->value;
-            NodeType* failureLink = child->parentLink->failureLink;
-            while (failureLink != nullptr)
+            auto& child = nodes[childId];
+            auto chr = child.value;
+            NodeId failureLink = nodes[child.parentLink].failureLink;
+            while (failureLink != InvalidNodeId)
             {
-                NodeType* nextLink = failureLink->children.TryGet(chr);
-                if (nextLink != nullptr)
+                NodeId nextLink = mChildren.TryGet(nodes[failureLink], failureLink, chr);
+                if (nextLink != RootNodeId)
                 {
                     failureLink = nextLink;
                     break;
                 }
 
-                failureLink = failureLink->failureLink;
+                failureLink = nodes[failureLink].failureLink;
             }
 
-            if (failureLink != nullptr)
+            if (failureLink != InvalidNodeId)
             {
-                child->failureLink = failureLink;
-                child->nextMatchLink = failureLink->word.empty() ? failureLink->nextMatchLink : failureLink;
+                const auto& failureNode = nodes[failureLink];
+                child.failureLink = failureLink;
+                child.nextMatchLink = failureNode.matchIndex == NodeType::InvalidMatchIndex ? failureNode.nextMatchLink : failureLink;
             }
             else
-                child->failureLink = &mRoot;
+                child.failureLink = RootNodeId;
         }
 
-        void BuildLinks()
+        void BuildLinks(std::vector<NodeType>& nodes, size_t threadCount)
         {
-            std::queue<NodeType*> queue;
-            queue.push(&mRoot);
-            do
+            // node ids follow BFS order, so plain iteration visits parents (and failure links) first; links of a node
+            // depend on shallower nodes only, so nodes of the same level can be processed concurrently
+            ForEachLevel(nodes, threadCount, [this, &nodes](size_t first, size_t last)
             {
-                auto node = queue.front();
-                queue.pop();
+                for (size_t id = first; id < last; ++id)
+                    BuildChildLink(nodes, (NodeId)id);
+            });
 
-                for (auto& slot : node->children.nodes)
-                {
-                    auto ptr = node->children.GetFromStorageSlot(slot);
-                    if (ptr == nullptr)
-                        continue;
+            ForEachLevel(nodes, threadCount, [this, &nodes](size_t first, size_t last)
+            {
+                mChildren.BuildTransitions(nodes, first, last);
+            });
+        }
+    };
+
+
+    /**
+     * \brief Epoch based reclamation: readers announce the epoch they started in, writer frees objects retired 
+     * before the oldest announced epoch.
+     */
+    class EpochDomain
+    {
+    public:
+        static const uint64_t Inactive = 0;
 
-                    BuildChildLink(ptr);
-                    queue.push(ptr);
+        EpochDomain() : mEpoch(1), mSlotCount(GetSlotCount()), mSlots(new Slot[mSlotCount])
+        {
+            for (size_t i = 0; i < mSlotCount; ++i)
+                mSlots[i].epoch.store(Inactive);
+        }
+
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        size_t Enter() noexcept
+        {
+            size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+            for (;;)
+            {
+                for (size_t i = 0; i < mSlotCount; ++i)
+                {
+                    size_t slot = (start + i) % mSlotCount;
+                    uint64_t expected = Inactive;
+                    if (mSlots[slot].epoch.load(std::memory_order_relaxed) == Inactive 
+                        && mSlots[slot].epoch.compare_exchange_strong(expected, mEpoch.load()))
+                        return slot;
                 }
-            } while (!queue.empty());
+
+                // more concurrent readers than slots
+                std::this_thread::yield();
+            }
         }
 
-        bool AddWord(const StringType& word)
+        void Leave(size_t slot) noexcept
         {
-            if (word.empty())
-                return false;
+            mSlots[slot].epoch.store(Inactive);
+        }
+
+        /**
+         * \brief Starts a new epoch, returns the previous one (objects unpublished before the call are retired in it).
+         */
+        uint64_t Advance() noexcept
+        {
+            return mEpoch.fetch_add(1);
+        }
+
+        /**
+         * \brief Returns the oldest epoch a reader may still be in, objects retired in earlier epochs can be freed.
+         */
+        uint64_t GetMinActive() const noexcept
+        {
+            uint64_t result = std::numeric_limits<uint64_t>::max();
+            for (size_t i = 0; i < mSlotCount; ++i)
+            {
+                uint64_t epoch = mSlots[i].epoch.load();
+                if (epoch != Inactive)
+                    result = std::min(result, epoch);
+            }
+
+            return result;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> epoch;
+            // one slot per cache line, readers don't invalidate each other's lines
+            char padding[64 - sizeof(std::atomic<uint64_t>)];
+        };
+
+        static const size_t MinSlotCount = 64;
+
+        static size_t GetSlotCount() noexcept
+        {
+            size_t count = (size_t)std::thread::hardware_concurrency() * 4;
+            return count > MinSlotCount ? count : MinSlotCount;
+        }
+
+        std::atomic<uint64_t> mEpoch;
+        size_t mSlotCount;
+        std::unique_ptr<Slot[]> mSlots;
+    };
+
+    template <class StringType, PerformanceStrategy strategy, MatchKind kind>
+    class UpdatableScannerImpl
+    {
+    public:
+        typedef typename StringType::value_type ValueType;
+        typedef ScannerImpl<StringType, strategy, kind> VersionType;
+
+        explicit UpdatableScannerImpl(const ScannerOptions& options) : mOptions(options), mBuilder(options.memoryResource), mVersion(0)
+        {
+            mNormalizer.Build(options);
+            mCurrent.store(new VersionType(mBuilder, mWords, mOptions));
+        }
+
+        UpdatableScannerImpl(const UpdatableScannerImpl&) = delete;
+        UpdatableScannerImpl& operator=(const UpdatableScannerImpl&) = delete;
+
+        ~UpdatableScannerImpl()
+        {
+            delete mCurrent.load();
+        }
+
+        template <class MatchCallback, class InputIt, class ContinueSearchCallback>
+        void Scan(const MatchCallback& callback, InputIt begin, InputIt end, ContinueSearchCallback continueSearchCallback)
+        {
+            ReadGuard guard(mDomain);
+            mCurrent.load()->Scan(callback, begin, end, continueSearchCallback);
+        }
+
+        template <class AddIt, class RemoveIt>
+        bool Update(AddIt addBegin, AddIt addEnd, RemoveIt removeBegin, RemoveIt removeEnd)
+        {
+            std::lock_guard<std::mutex> lock(mUpdateLock);
 
-            auto* currentNode = &mRoot;
-            for (const auto& c : word)
+            bool changed = false;
+            for (RemoveIt it = removeBegin; it != removeEnd; ++it)
             {
-                NodeType* found = nullptr;
-                if (currentNode->children.AddOrGet(c, found) == NodeSearchResult::Added)
-                    found->parentLink = currentNode;
+                auto id = mIds.find(*it);
+                if (id == mIds.end())
+                    continue;
 
-                currentNode = found;
+                mBuilder.RemoveWord(id->first, mNormalizer);
+                mWords[id->second] = StringType();
+                mIds.erase(id);
+                changed = true;
             }
 
-            if (!currentNode->word.empty())
-                return false;
+            // unlinked nodes are never reused, compact the trie when they prevail
+            if (mBuilder.detachedCount > mBuilder.nodes.size() / 2)
+            {
+                mBuilder = TrieBuilder<ValueType, StringType>(mOptions.memoryResource);
+                for (const auto& id : mIds)
+                    mBuilder.AddWord(id.first, id.second, mNormalizer);
+            }
+
+            for (AddIt it = addBegin; it != addEnd; ++it)
+            {
+                if (mBuilder.AddWord(*it, mWords.size(), mNormalizer))
+                {
+                    mIds.emplace(*it, mWords.size());
+                    mWords.push_back(*it);
+                    changed = true;
+                }
+            }
 
-            currentNode->matchIndex = mCurrentIndex++;
-            currentNode->word = word;
+            if (changed)
+                Publish();
 
-            return true;
+            return changed;
+        }
+
+        uint64_t GetVersion() const noexcept { return mVersion.load(); }
+
+    private:
+        class ReadGuard
+        {
+        public:
+            explicit ReadGuard(EpochDomain& domain) noexcept : mDomain(domain), mSlot(domain.Enter()) {}
+            ~ReadGuard() { mDomain.Leave(mSlot); }
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+        private:
+            EpochDomain& mDomain;
+            size_t mSlot;
+        };
+
+        void Publish()
+        {
+            std::unique_ptr<VersionType> previous(mCurrent.exchange(new VersionType(mBuilder, mWords, mOptions)));
+            // readers entered after the advance see the new version only
+            mRetired.emplace_back(mDomain.Advance(), std::move(previous));
+            ++mVersion;
+
+            uint64_t minActive = mDomain.GetMinActive();
+            mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), 
+                [minActive](const std::pair<uint64_t, std::unique_ptr<VersionType>>& retired) { return retired.first < minActive; }), 
+                mRetired.end());
         }
+
+        ScannerOptions mOptions;
+        Normalizer<ValueType> mNormalizer;
+        // trie kept between updates, every version is flattened from it
+        TrieBuilder<ValueType, StringType> mBuilder;
+        // patterns indexed by id, removed ones are empty
+        std::vector<StringType> mWords;
+        std::map<StringType, uint32_t> mIds;
+        std::mutex mUpdateLock;
+        EpochDomain mDomain;
+        std::atomic<VersionType*> mCurrent;
+        // replaced versions with epoch of their replacement
+        std::vector<std::pair<uint64_t, std::unique_ptr<VersionType>>> mRetired;
+        std::atomic<uint64_t> mVersion;
     };
 
 #pragma endregion Implementation
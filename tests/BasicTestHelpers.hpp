@@ -44,7 +44,9 @@ template <class MatchContainerType, class StringContainerType, class StringType>
 static bool BasicStrTestAllStrategies(StringType text, MatchContainerType matches, StringContainerType strings)
 {
 	return BasicStrTest<AhoCorasick::PerformanceStrategy::Balanced>(text, matches, strings)
-		&& BasicStrTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>(text, matches, strings);
+		&& BasicStrTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>(text, matches, strings)
+		&& BasicStrTest<AhoCorasick::PerformanceStrategy::Dfa>(text, matches, strings)
+		&& BasicStrTest<AhoCorasick::PerformanceStrategy::Adaptive>(text, matches, strings);
 }
 
 template <AhoCorasick::PerformanceStrategy strategy, class MatchContainerType, class StringContainerType,
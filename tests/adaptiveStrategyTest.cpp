@@ -0,0 +1,54 @@
+#include "BasicTestHelpers.hpp"
+
+// Builds patterns wide enough to make root and first level nodes use bitmap and hash representations
+// and checks Adaptive strategy reports exactly what Balanced does.
+template <class StringClass>
+static bool CompareWithBalanced(typename StringClass::value_type step)
+{
+	typedef AhoCorasick::Match<StringClass> StringMatch;
+	typedef typename StringClass::value_type ValueType;
+
+	std::vector<StringClass> strings;
+	for (ValueType i = 0; i < 40; ++i)
+	{
+		strings.push_back(StringClass{ (ValueType)(i * step) });
+		strings.push_back(StringClass{ (ValueType)(i * step), (ValueType)(i * step + step), (ValueType)(i * step + 2 * step) });
+	}
+
+	StringClass text;
+	for (ValueType i = 0; i < 45; ++i)
+		text.push_back((ValueType)(i * step));
+
+	std::vector<StringMatch> expected;
+	AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Balanced> balanced(strings.begin(), strings.end());
+	balanced.Scan([&expected](const StringMatch& m)
+	{
+		expected.emplace_back(m.offset, m.index, m.word);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return expected.size() == 40 + 40 && BasicStrTest<AhoCorasick::PerformanceStrategy::Adaptive>(text, expected, strings);
+}
+
+int main()
+{
+	if (!CompareWithBalanced<std::vector<uint64_t>>(1))
+	{
+		std::cerr << "Bitmap test failed\n";
+		return 1;
+	}
+
+	if (!CompareWithBalanced<std::vector<uint64_t>>(0x10000000001ull))
+	{
+		std::cerr << "Hash test failed\n";
+		return 2;
+	}
+
+	if (!CompareWithBalanced<std::wstring>(1000))
+	{
+		std::cerr << "Wide char hash test failed\n";
+		return 3;
+	}
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "BasicTestHelpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+typedef std::string StringClass;
+
+static std::vector<StringClass> strings = { "he", "she", "his", "hers" };
+static const char* fileName = "automatonStatsTest.bin";
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool StatsTest()
+{
+	typedef AhoCorasick::Scanner<StringClass, strategy> ScannerType;
+	ScannerType scanner(strings.begin(), strings.end());
+	auto stats = scanner.GetAutomatonStats();
+
+	// root, h, he, her, hers, hi, his, s, sh, she
+	if (stats.nodeCount != 10 || stats.patternCount != 4 || stats.alphabetSize != 5)
+		return false;
+
+	if (stats.fanouts != std::vector<size_t>{ 3, 5, 2 } || stats.depths != std::vector<size_t>{ 1, 2, 3, 3, 1 })
+		return false;
+
+	// "she" -> "he" -> root, "she" reports "she" and "he"
+	if (stats.maxFailureChain != 2 || stats.maxOutputChain != 2 || stats.averageOutputChain != 0.5)
+		return false;
+
+	if (stats.nodeBytes == 0 || stats.childrenBytes == 0 || stats.patternBytes == 0
+		|| stats.GetTotalBytes() != stats.nodeBytes + stats.childrenBytes + stats.auxiliaryBytes + stats.patternBytes)
+		return false;
+
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		if (!scanner.Save(stream))
+			return false;
+	}
+
+	// loaded scanner has the same structure without pattern copies
+	auto loaded = ScannerType::Load(fileName);
+	if (!loaded)
+		return false;
+
+	auto loadedStats = loaded->GetAutomatonStats();
+	return loadedStats.nodeCount == stats.nodeCount && loadedStats.childrenBytes == stats.childrenBytes 
+		&& loadedStats.fanouts == stats.fanouts && loadedStats.patternBytes == 0;
+}
+
+static bool StrategyFootprintTest()
+{
+	auto balanced = AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Balanced>(strings.begin(), strings.end())
+		.GetAutomatonStats();
+	auto table = AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::MaximumPerformance>(strings.begin(), strings.end())
+		.GetAutomatonStats();
+
+	// table row per node: alphabetSize classes plus the one shared by unused 'characters'
+	return table.childrenBytes > balanced.childrenBytes
+		&& table.childrenBytes >= table.nodeCount * (table.alphabetSize + 1) * sizeof(AhoCorasick::NodeId);
+}
+
+int main()
+{
+	bool result = StatsTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		&& StatsTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		&& StatsTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		&& StatsTest<AhoCorasick::PerformanceStrategy::Adaptive>()
+		&& StrategyFootprintTest();
+
+	std::remove(fileName);
+	if (!result)
+	{
+		std::cerr << "Automaton stats test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+#include <utility>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+typedef std::pair<StringClass::const_iterator, StringClass::const_iterator> Range;
+
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something", "he", "hell", "a" };
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool BatchTest()
+{
+	AhoCorasick::Scanner<StringClass, strategy> scanner(strings.begin(), strings.end());
+
+	// more documents than lanes, of different sizes including empty ones
+	std::vector<StringClass> documents;
+	for (size_t i = 0; i < 37; ++i)
+	{
+		StringClass document;
+		for (size_t j = 0; j < i % 11; ++j)
+			document += strings[(i + j) % strings.size()] + (j % 3 == 0 ? "-" : " x ");
+
+		documents.push_back(document);
+	}
+
+	std::vector<Range> ranges;
+	std::vector<std::vector<StringMatch>> expected(documents.size());
+	for (size_t i = 0; i < documents.size(); ++i)
+	{
+		ranges.emplace_back(documents[i].cbegin(), documents[i].cend());
+		scanner.Scan([&expected, i](const StringMatch& m)
+		{
+			expected[i].push_back(m);
+			return true;
+		}, documents[i].cbegin(), documents[i].cend());
+	}
+
+	std::vector<std::vector<StringMatch>> found(documents.size());
+	scanner.ScanBatch(ranges.begin(), ranges.end(), [&found](size_t stream, const StringMatch& m)
+	{
+		found[stream].push_back(m);
+		return true;
+	});
+
+	for (size_t i = 0; i < documents.size(); ++i)
+	{
+		if (expected[i].size() != found[i].size()
+			|| !std::equal(expected[i].begin(), expected[i].end(), found[i].begin(), compareMatches<StringMatch>))
+			return false;
+	}
+
+	// stopping a stream doesn't affect the others
+	std::vector<size_t> counts(documents.size());
+	scanner.ScanBatch(ranges.begin(), ranges.end(), [&counts](size_t stream, const StringMatch&)
+	{
+		++counts[stream];
+		return stream % 2 == 0;
+	});
+
+	for (size_t i = 0; i < documents.size(); ++i)
+	{
+		size_t expectedCount = i % 2 == 0 ? expected[i].size() : std::min<size_t>(expected[i].size(), 1);
+		if (counts[i] != expectedCount)
+			return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	if (!BatchTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !BatchTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !BatchTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !BatchTest<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Batch scan test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "BasicTestHelpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+typedef std::string StringClass;
+typedef std::vector<std::pair<size_t, size_t>> MatchList;
+
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something", "he", "hell", "a" };
+static const char* fileName = "fileScanTest.txt";
+static const char* emptyFileName = "fileScanTestEmpty.txt";
+
+static StringClass MakeText()
+{
+	StringClass text;
+	for (size_t i = 0; i < 3000; ++i)
+		text += strings[i % strings.size()] + (i % 7 == 0 ? " " : "-x") + strings[(i * 5) % strings.size()];
+
+	return text;
+}
+
+static auto Collector(MatchList& found)
+{
+	return [&found](const AhoCorasick::Match<StringClass>& m)
+	{
+		found.emplace_back(m.offset, m.index);
+		return true;
+	};
+}
+
+template <AhoCorasick::PerformanceStrategy strategy, AhoCorasick::MatchKind kind>
+static bool FileTest(const StringClass& text)
+{
+	AhoCorasick::Scanner<StringClass, strategy, kind> scanner(strings.begin(), strings.end());
+	MatchList expected, found;
+	scanner.Scan(Collector(expected), text.cbegin(), text.cend());
+	if (!scanner.ScanFile(fileName, Collector(found)) || found != expected)
+		return false;
+
+	found.clear();
+	if (!scanner.ScanFile(emptyFileName, Collector(found)) || !found.empty() || scanner.ScanFile("no such file", Collector(found)))
+		return false;
+
+#if !defined(_WIN32)
+	// regular file is scanned from the current position
+	const size_t skipped = 1000;
+	MatchList tail;
+	scanner.Scan(Collector(tail), text.cbegin() + skipped, text.cend());
+	found.clear();
+	int file = open(fileName, O_RDONLY);
+	bool result = file >= 0 && lseek(file, skipped, SEEK_SET) == (off_t)skipped && scanner.ScanFd(file, Collector(found));
+	close(file);
+	if (!result || found != tail)
+		return false;
+
+	// tiny buffers of a pipe split most of the matches
+	for (size_t bufferSize : { 1, 3, 64, 100000 })
+	{
+		int pipes[2];
+		if (pipe(pipes) != 0)
+			return false;
+
+		std::thread writer([&text, &pipes]()
+		{
+			for (size_t offset = 0; offset < text.size(); offset += 777)
+			{
+				size_t size = std::min<size_t>(777, text.size() - offset);
+				if (write(pipes[1], text.data() + offset, size) != (ssize_t)size)
+					break;
+			}
+
+			close(pipes[1]);
+		});
+
+		found.clear();
+		result = scanner.ScanFd(pipes[0], Collector(found), bufferSize);
+		writer.join();
+		close(pipes[0]);
+		if (!result || found != expected)
+			return false;
+	}
+#endif
+
+	return true;
+}
+
+#if !defined(_WIN32)
+static bool StopTest(const StringClass& text)
+{
+	// writer keeps the pipe open, scanning stopped by callback must return anyway
+	AhoCorasick::Scanner<StringClass> scanner(strings.begin(), strings.end());
+	int pipes[2];
+	if (pipe(pipes) != 0 || write(pipes[1], text.data(), 4096) != 4096)
+		return false;
+
+	size_t count = 0;
+	bool result = scanner.ScanFd(pipes[0], [&count](const AhoCorasick::Match<StringClass>&) { return ++count < 10; }, 512);
+	close(pipes[1]);
+	close(pipes[0]);
+	return result && count == 10;
+}
+#endif
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool FileTestAll(const StringClass& text)
+{
+	return FileTest<strategy, AhoCorasick::MatchKind::All>(text)
+		&& FileTest<strategy, AhoCorasick::MatchKind::LeftmostLongest>(text);
+}
+
+int main()
+{
+	const StringClass text = MakeText();
+	{
+		std::ofstream file(fileName, std::ios::binary);
+		file << text;
+		std::ofstream empty(emptyFileName, std::ios::binary);
+	}
+
+	bool result = FileTestAll<AhoCorasick::PerformanceStrategy::Balanced>(text)
+		&& FileTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>(text)
+		&& FileTestAll<AhoCorasick::PerformanceStrategy::Dfa>(text)
+		&& FileTestAll<AhoCorasick::PerformanceStrategy::Adaptive>(text);
+
+#if !defined(_WIN32)
+	result = result && StopTest(text);
+#endif
+
+	std::remove(fileName);
+	std::remove(emptyFileName);
+	if (!result)
+	{
+		std::cerr << "File scan test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
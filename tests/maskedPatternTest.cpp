@@ -0,0 +1,146 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+#include <utility>
+
+typedef std::vector<std::pair<size_t, size_t>> MatchList;
+
+template <class StringClass>
+static MatchList BruteForce(const std::vector<AhoCorasick::MaskedPattern<StringClass>>& patterns, const StringClass& text)
+{
+	MatchList result;
+	for (size_t index = 0; index < patterns.size(); ++index)
+	{
+		const auto& pattern = patterns[index];
+		bool anchored = false;
+		for (auto mask : pattern.mask)
+			anchored = anchored || mask == (typename StringClass::value_type)~0ull;
+
+		for (size_t offset = 0; anchored && offset + pattern.value.size() <= text.size(); ++offset)
+		{
+			bool matched = true;
+			for (size_t i = 0; i < pattern.value.size() && matched; ++i)
+				matched = ((text[offset + i] ^ pattern.value[i]) & pattern.mask[i]) == 0;
+
+			if (matched)
+				result.emplace_back(offset, index);
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy, class StringClass>
+static bool MaskedTest(const std::vector<AhoCorasick::MaskedPattern<StringClass>>& patterns, const StringClass& text)
+{
+	AhoCorasick::MaskedScanner<StringClass, strategy> scanner(patterns.begin(), patterns.end());
+	MatchList found;
+	bool wordsValid = true;
+	scanner.Scan([&found, &wordsValid, &patterns](const AhoCorasick::Match<StringClass>& m)
+	{
+		found.emplace_back(m.offset, m.index);
+		wordsValid = wordsValid && *m.word == patterns[m.index].value && m.length == m.word->size();
+		return true;
+	}, text.cbegin(), text.cend());
+
+	std::sort(found.begin(), found.end());
+	auto expected = BruteForce(patterns, text);
+	if (!wordsValid || expected.empty() || found != expected)
+		return false;
+
+	// stop after the first match
+	size_t count = 0;
+	scanner.Scan([&count](const AhoCorasick::Match<StringClass>&) { ++count; return false; }, text.cbegin(), text.cend());
+	return count == 1;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool SignatureTest()
+{
+	typedef std::vector<uint8_t> StringClass;
+	std::vector<std::string> signatures = {
+		"4D 5A ?? ?? 50 45",
+		"4D5A????5045????4C01",  // shares anchor with the first one
+		"?? ?? 13 37 ?? C0 DE",
+		"E8 ?? ?? ?? ?? 5? C3",  // anchor at the end, nibble wildcard
+		"?? ?? ??",              // no anchor, never reported
+		"FF",
+	};
+
+	std::vector<AhoCorasick::MaskedPattern<StringClass>> patterns(signatures.size());
+	for (size_t i = 0; i < signatures.size(); ++i)
+	{
+		if (!AhoCorasick::ParseHexSignature(signatures[i], patterns[i]))
+			return false;
+	}
+
+	StringClass text;
+	uint32_t seed = 99;
+	for (size_t i = 0; i < 20000; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		text.push_back((uint8_t)(seed >> 16));
+	}
+
+	// plant signatures with random wildcards including both ends of the input
+	std::vector<size_t> positions = { 0, 100, 2000, 5001, 9999, 15000, 19990 };
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		const auto& pattern = patterns[i % 4];
+		for (size_t j = 0; j < pattern.value.size() && positions[i] + j < text.size(); ++j)
+			text[positions[i] + j] = (uint8_t)((text[positions[i] + j] & ~pattern.mask[j]) | (pattern.value[j] & pattern.mask[j]));
+	}
+
+	return MaskedTest<strategy>(patterns, text);
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool WideMaskTest()
+{
+	// low bits are flags to ignore
+	typedef std::vector<uint64_t> StringClass;
+	std::vector<AhoCorasick::MaskedPattern<StringClass>> patterns = {
+		{ { 0x100, 0x200, 0x300 }, { ~0xFFull, ~0ull, ~0ull } },
+		{ { 0x200, 0x300, 0x400 }, { ~0ull, ~0ull, 0 } },
+		{ { 0x500, 0x600 }, { ~0ull, ~0xFull } },
+	};
+
+	StringClass text;
+	for (uint64_t i = 0; i < 3000; ++i)
+		text.push_back((((i * 7) % 6 + 1) << 8) | (i % 37));
+
+	return MaskedTest<strategy>(patterns, text);
+}
+
+static bool ParseTest()
+{
+	AhoCorasick::MaskedPattern<std::string> pattern;
+	if (!AhoCorasick::ParseHexSignature("4d 5A\t?F", pattern) || pattern.value != std::string("\x4D\x5A\x0F", 3) 
+		|| pattern.mask != std::string("\xFF\xFF\x0F", 3))
+		return false;
+
+	return !AhoCorasick::ParseHexSignature("4D 5", pattern) && !AhoCorasick::ParseHexSignature("4G", pattern)
+		&& !AhoCorasick::ParseHexSignature(" ", pattern);
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool MaskedTestAll()
+{
+	return SignatureTest<strategy>() && WideMaskTest<strategy>();
+}
+
+int main()
+{
+	if (!ParseTest()
+		|| !MaskedTestAll<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !MaskedTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !MaskedTestAll<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !MaskedTestAll<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Masked pattern test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static std::vector<StringClass> strings = { "abcd", "ab", "bcde", "cd", "e", "abcdefg" };
+static const StringClass text = "xabcdefgh abcde";
+
+static std::vector<StringMatch> expectedFirst = {
+	MakeMatch<StringMatch>(1,  0, strings),
+	MakeMatch<StringMatch>(5,  4, strings),
+	MakeMatch<StringMatch>(10, 0, strings),
+	MakeMatch<StringMatch>(14, 4, strings),
+};
+
+static std::vector<StringMatch> expectedLongest = {
+	MakeMatch<StringMatch>(1,  5, strings),
+	MakeMatch<StringMatch>(10, 0, strings),
+	MakeMatch<StringMatch>(14, 4, strings),
+};
+
+static std::vector<StringMatch> expectedExistence = {
+	MakeMatch<StringMatch>(1,  1, strings),
+};
+
+template <AhoCorasick::PerformanceStrategy strategy, AhoCorasick::MatchKind kind>
+static bool KindTest(const std::vector<StringMatch>& expected)
+{
+	AhoCorasick::Scanner<StringClass, strategy, kind> scanner(strings.begin(), strings.end());
+
+	std::vector<StringMatch> found;
+	scanner.Scan([&found](const StringMatch& m)
+	{
+		found.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	std::vector<size_t> counts;
+	scanner.Count(counts, text.cbegin(), text.cend());
+	for (size_t i = 0; i < strings.size(); ++i)
+	{
+		auto count = std::count_if(expected.begin(), expected.end(), [i](const StringMatch& m) { return m.index == i; });
+		if (counts[i] != (size_t)count)
+			return false;
+	}
+
+	return expected.size() == found.size() && std::equal(expected.begin(), expected.end(), found.begin(), compareMatches<StringMatch>);
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool KindTestAll()
+{
+	AhoCorasick::Scanner<StringClass, strategy> scanner(strings.begin(), strings.end());
+	std::vector<StringMatch> all;
+	scanner.Scan([&all](const StringMatch& m)
+	{
+		all.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return KindTest<strategy, AhoCorasick::MatchKind::All>(all)
+		&& KindTest<strategy, AhoCorasick::MatchKind::Existence>(expectedExistence)
+		&& KindTest<strategy, AhoCorasick::MatchKind::LeftmostFirst>(expectedFirst)
+		&& KindTest<strategy, AhoCorasick::MatchKind::LeftmostLongest>(expectedLongest);
+}
+
+int main()
+{
+	if (!KindTestAll<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !KindTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !KindTestAll<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !KindTestAll<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Match kind test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+#include <tuple>
+
+typedef std::tuple<uint64_t, size_t, size_t> RecordTuple;
+
+// dense output: single 'character' patterns and long overlapping chains
+template <class StringClass>
+static std::vector<StringClass> MakeStrings()
+{
+	return { StringClass(1, 'a'), StringClass(2, 'a'), StringClass(3, 'a'), StringClass(1, 'b'), StringClass(1, 'c'),
+		StringClass(2, 'b') + StringClass(1, 'c'), StringClass(1, 'c') + StringClass(1, 'a') };
+}
+
+template <AhoCorasick::PerformanceStrategy strategy, class StringClass>
+static bool RecordsTest()
+{
+	auto strings = MakeStrings<StringClass>();
+	AhoCorasick::Scanner<StringClass, strategy> scanner(strings.begin(), strings.end());
+	StringClass text;
+	for (size_t i = 0; i < 1000; ++i)
+		text += (typename StringClass::value_type)("aaabbcaxcab"[i % 11]);
+
+	std::vector<RecordTuple> expected;
+	scanner.Scan([&expected](const AhoCorasick::Match<StringClass>& m)
+	{
+		expected.emplace_back(m.offset + m.length, m.index, m.length);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	for (size_t capacity : { 1, 2, 3, 7, 64, 100000 })
+	{
+		// input is given in two chunks, the state carries matches crossing them
+		std::vector<AhoCorasick::MatchRecord> records(capacity);
+		std::vector<RecordTuple> found;
+		AhoCorasick::ScanState state;
+		size_t split = text.size() / 3;
+		for (size_t chunk = 0; chunk < 2; ++chunk)
+		{
+			auto begin = chunk == 0 ? text.cbegin() : text.cbegin() + split;
+			auto end = chunk == 0 ? text.cbegin() + split : text.cend();
+			size_t count = 0;
+			do
+			{
+				count = scanner.ScanRecords(state, begin, end, records.data(), capacity);
+				for (size_t i = 0; i < count; ++i)
+					found.emplace_back(records[i].endOffset, records[i].index, records[i].length);
+			} while (count == capacity);
+
+			if (begin != end)
+				return false;
+		}
+
+		if (found != expected)
+			return false;
+	}
+
+	return true;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool RecordsTestAll()
+{
+	return RecordsTest<strategy, std::string>() && RecordsTest<strategy, std::wstring>();
+}
+
+int main()
+{
+	if (!RecordsTestAll<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !RecordsTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !RecordsTestAll<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !RecordsTestAll<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Match records test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
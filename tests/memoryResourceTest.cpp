@@ -0,0 +1,91 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something", "he", "hell" };
+static const StringClass text = "First word is hello, the secoind one is world. And lets add something else, bla-bla-bla, hell";
+
+class CountingResource : public AhoCorasick::MemoryResource
+{
+public:
+	size_t allocated = 0;
+	size_t released = 0;
+	bool sizesValid = true;
+
+	void* Allocate(size_t size, size_t alignment) override
+	{
+		++allocated;
+		sizesValid = sizesValid && size != 0 && (alignment & (alignment - 1)) == 0;
+		return ::operator new(size);
+	}
+
+	void Deallocate(void* block, size_t, size_t) noexcept override
+	{
+		++released;
+		::operator delete(block);
+	}
+};
+
+template <class ScannerType>
+static std::vector<StringMatch> ScanText(ScannerType& scanner)
+{
+	std::vector<StringMatch> found;
+	scanner.Scan([&found](const StringMatch& m)
+	{
+		found.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return found;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool ResourceTest()
+{
+	AhoCorasick::Scanner<StringClass, strategy> defaultScanner(strings.begin(), strings.end());
+	auto expected = ScanText(defaultScanner);
+
+	CountingResource resource;
+	AhoCorasick::ScannerOptions options;
+	options.memoryResource = &resource;
+	{
+		AhoCorasick::Scanner<StringClass, strategy> scanner(strings.begin(), strings.end(), options);
+		// construction trie is released before the scanner is ready
+		if (resource.allocated == 0 || resource.allocated != resource.released)
+			return false;
+
+		auto found = ScanText(scanner);
+		if (expected.size() != found.size() || !std::equal(expected.begin(), expected.end(), found.begin(), compareMatches<StringMatch>))
+			return false;
+	}
+
+	{
+		AhoCorasick::UpdatableScanner<StringClass, strategy> scanner(options);
+		scanner.Add(strings.begin(), strings.end());
+		scanner.Remove(strings.begin(), strings.begin() + 2);
+		scanner.Add(strings.begin(), strings.begin() + 2);
+
+		auto found = ScanText(scanner);
+		if (expected.size() != found.size())
+			return false;
+	}
+
+	return resource.allocated == resource.released && resource.sizesValid;
+}
+
+int main()
+{
+	if (!ResourceTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !ResourceTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !ResourceTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !ResourceTest<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Memory resource test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
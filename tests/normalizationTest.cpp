@@ -0,0 +1,82 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+
+template <AhoCorasick::PerformanceStrategy strategy, class StringType>
+static bool NormalizationTest(const std::vector<StringType>& strings, const StringType& text,
+	const AhoCorasick::ScannerOptions& options, const std::vector<std::pair<size_t, size_t>>& expected)
+{
+	typedef AhoCorasick::Match<StringType> StringMatch;
+	AhoCorasick::Scanner<StringType, strategy> scanner(strings.begin(), strings.end(), options);
+	if (scanner.GetEngine() != AhoCorasick::ScannerEngine::Automaton)
+		return false;
+
+	std::vector<std::pair<size_t, size_t>> found;
+	bool wordsValid = true;
+	scanner.Scan([&found, &wordsValid, &strings](const StringMatch& m)
+	{
+		found.emplace_back(m.offset, m.index);
+		// word points to the original pattern
+		wordsValid = wordsValid && *m.word == strings[m.index];
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return wordsValid && found == expected;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool CaseFoldingTest()
+{
+	std::vector<std::string> strings = { "hello", "WORLD", "Bla-Bla" };
+	const std::string text = "HeLLo wOrld! bla-BLA, Hello";
+	AhoCorasick::ScannerOptions options;
+	options.normalization = AhoCorasick::Normalization::AsciiCaseFolding;
+
+	std::vector<std::wstring> wideStrings = { L"hello", L"WORLD", L"Bla-Bla" };
+	const std::wstring wideText = L"HeLLo wOrld! bla-BLA, Hello";
+	std::vector<std::pair<size_t, size_t>> expected = { { 0, 0 }, { 6, 1 }, { 13, 2 }, { 22, 0 } };
+
+	return NormalizationTest<strategy>(strings, text, options, expected)
+		&& NormalizationTest<strategy>(wideStrings, wideText, options, expected);
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool CustomTableTest()
+{
+	// all digits are equal, all whitespace is a space
+	AhoCorasick::ScannerOptions options;
+	options.normalization = AhoCorasick::Normalization::Custom;
+	for (size_t c = 0; c < options.translation.size(); ++c)
+		options.translation[c] = (uint8_t)c;
+
+	for (char c = '1'; c <= '9'; ++c)
+		options.translation[(uint8_t)c] = '0';
+
+	options.translation['\t'] = ' ';
+	options.translation['\n'] = ' ';
+
+	std::vector<std::string> strings = { "id 00", "0-0", "id 12" };
+	const std::string text = "id\t42, id 7-3 id\n99";
+	// "id 12" is a duplicate of "id 00" after normalization
+	std::vector<std::pair<size_t, size_t>> expected = { { 0, 0 }, { 10, 1 }, { 14, 0 } };
+
+	return NormalizationTest<strategy>(strings, text, options, expected);
+}
+
+int main()
+{
+	if (!CaseFoldingTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !CaseFoldingTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !CaseFoldingTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !CaseFoldingTest<AhoCorasick::PerformanceStrategy::Adaptive>()
+		|| !CustomTableTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !CustomTableTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !CustomTableTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !CustomTableTest<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Normalization test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
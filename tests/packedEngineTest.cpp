@@ -0,0 +1,76 @@
+#include "BasicTestHelpers.hpp"
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static const StringClass text[] = { "First word is hello, the secoind one is world. And lets add some", "thing else" };
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something", "d", "" };
+
+static std::vector<StringMatch> expected = {
+	MakeMatch<StringMatch>(9, 6, strings),
+	MakeMatch<StringMatch>(14, 0, strings),
+	MakeMatch<StringMatch>(31, 6, strings),
+	MakeMatch<StringMatch>(41, 4, strings),
+	MakeMatch<StringMatch>(40, 1, strings),
+	MakeMatch<StringMatch>(41, 3, strings),
+	MakeMatch<StringMatch>(44, 6, strings),
+	MakeMatch<StringMatch>(49, 6, strings),
+	MakeMatch<StringMatch>(57, 6, strings),
+	MakeMatch<StringMatch>(58, 6, strings),
+	MakeMatch<StringMatch>(60, 5, strings),
+};
+
+class TestContinueHandler
+{
+public:
+	bool operator()(StringClass::const_iterator& begin, StringClass::const_iterator& end)
+	{
+		if (++mIndex >= sizeof(text) / sizeof(text[0]))
+			return false;
+
+		begin = text[mIndex].begin();
+		end = text[mIndex].end();
+
+		return true;
+	}
+
+private:
+	size_t mIndex = 0;
+};
+
+static bool EngineTest(AhoCorasick::ScannerEngine engine)
+{
+	AhoCorasick::ScannerOptions options;
+	options.engine = engine;
+
+	AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa> scanner(strings.begin(), strings.end(), options);
+	if (scanner.GetEngine() != engine)
+		return false;
+
+	std::vector<StringMatch> found;
+	scanner.Scan([&found](const StringMatch& m)
+	{
+		found.emplace_back(m.offset, m.index, m.word);
+		return true;
+	}, text[0].cbegin(), text[0].cend(), TestContinueHandler());
+
+	return expected.size() == found.size()
+		&& std::equal(expected.begin(), expected.end(), found.begin(), compareMatches<StringMatch>);
+}
+
+int main()
+{
+	if (!EngineTest(AhoCorasick::ScannerEngine::PackedSimd))
+	{
+		std::cerr << "Packed engine test failed\n";
+		return 1;
+	}
+
+	if (!EngineTest(AhoCorasick::ScannerEngine::Automaton))
+	{
+		std::cerr << "Automaton engine test failed\n";
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+#include "BasicTestHelpers.hpp"
+
+#include <random>
+#include <sstream>
+#include <string>
+
+template <class StringType>
+static std::vector<StringType> MakePatterns(size_t count, size_t alphabetSize)
+{
+	std::mt19937 generator(12345);
+	std::vector<StringType> patterns;
+	for (size_t i = 0; i < count; ++i)
+	{
+		StringType pattern;
+		size_t length = 1 + generator() % 12;
+		for (size_t j = 0; j < length; ++j)
+			pattern.push_back((typename StringType::value_type)('a' + generator() % alphabetSize));
+
+		patterns.push_back(pattern);
+	}
+
+	// duplicates must get the index of the first occurrence
+	patterns.push_back(patterns[0]);
+	patterns.push_back(StringType());
+	return patterns;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy, class StringType>
+static bool ParallelBuildTest(const std::vector<StringType>& patterns, size_t threadCount)
+{
+	typedef AhoCorasick::Scanner<StringType, strategy> ScannerType;
+	ScannerType serial(patterns.begin(), patterns.end());
+
+	AhoCorasick::ScannerOptions options;
+	options.buildThreadCount = threadCount;
+	ScannerType parallel(patterns.begin(), patterns.end(), options);
+
+	// automatons must be identical
+	std::ostringstream serialStream, parallelStream;
+	if (!serial.Save(serialStream) || !parallel.Save(parallelStream))
+		return false;
+
+	if (serialStream.str() != parallelStream.str())
+		return false;
+
+	StringType text;
+	for (size_t i = 0; i < 200; ++i)
+		text += patterns[i * 7 % patterns.size()];
+
+	std::vector<AhoCorasick::Match<StringType>> expected, found;
+	serial.Scan([&expected](const AhoCorasick::Match<StringType>& m)
+	{
+		expected.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	parallel.Scan([&found](const AhoCorasick::Match<StringType>& m)
+	{
+		found.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return !expected.empty() && expected.size() == found.size()
+		&& std::equal(expected.begin(), expected.end(), found.begin(), compareMatches<AhoCorasick::Match<StringType>>);
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool ParallelBuildTestAll()
+{
+	// small alphabet makes BFS levels wide enough to be split between threads
+	auto patterns = MakePatterns<std::string>(100000, 4);
+	auto widePatterns = MakePatterns<std::wstring>(20000, 26);
+	return ParallelBuildTest<strategy>(patterns, 4)
+		&& ParallelBuildTest<strategy>(patterns, 3)
+		&& ParallelBuildTest<strategy>(patterns, 0)
+		&& ParallelBuildTest<strategy>(widePatterns, 4);
+}
+
+int main()
+{
+	if (!ParallelBuildTestAll<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !ParallelBuildTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !ParallelBuildTestAll<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !ParallelBuildTestAll<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Parallel build test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include "BasicTestHelpers.hpp"
+
+#include <mutex>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static bool LessMatch(const StringMatch& lhs, const StringMatch& rhs)
+{
+	return lhs.offset < rhs.offset || (lhs.offset == rhs.offset && lhs.index < rhs.index);
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool ParallelTest(const StringClass& text, const std::vector<StringClass>& strings, size_t chunkSize)
+{
+	AhoCorasick::Scanner<StringClass, strategy> scanner(strings.begin(), strings.end());
+
+	std::vector<StringMatch> expected;
+	scanner.Scan([&expected](const StringMatch& m)
+	{
+		expected.emplace_back(m.offset, m.index, m.word);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	AhoCorasick::ParallelScanOptions options;
+	options.threadCount = 4;
+	options.chunkSize = chunkSize;
+
+	std::vector<StringMatch> ordered;
+	scanner.ScanParallel([&ordered](const StringMatch& m)
+	{
+		ordered.emplace_back(m.offset, m.index, m.word);
+		return true;
+	}, text.cbegin(), text.cend(), options);
+
+	if (ordered.size() != expected.size()
+		|| !std::equal(expected.begin(), expected.end(), ordered.begin(), compareMatches<StringMatch>))
+		return false;
+
+	options.ordered = false;
+	std::mutex lock;
+	std::vector<StringMatch> unordered;
+	scanner.ScanParallel([&unordered, &lock](const StringMatch& m)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		unordered.emplace_back(m.offset, m.index, m.word);
+		return true;
+	}, text.cbegin(), text.cend(), options);
+
+	std::sort(expected.begin(), expected.end(), LessMatch);
+	std::sort(unordered.begin(), unordered.end(), LessMatch);
+	return unordered.size() == expected.size()
+		&& std::equal(expected.begin(), expected.end(), unordered.begin(), compareMatches<StringMatch>);
+}
+
+int main()
+{
+	std::vector<StringClass> strings = { "abcab", "bca", "ca", "c", "aaaa", "bab" };
+
+	StringClass text;
+	uint32_t seed = 1;
+	for (size_t i = 0; i < 100000; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		text.push_back("abc"[(seed >> 16) % 3]);
+	}
+
+	for (size_t chunkSize : { 1, 3, 4, 5, 7, 1000, 0 })
+	{
+		if (!ParallelTest<AhoCorasick::PerformanceStrategy::Balanced>(text, strings, chunkSize)
+			|| !ParallelTest<AhoCorasick::PerformanceStrategy::Dfa>(text, strings, chunkSize))
+		{
+			std::cerr << "Parallel scan test failed for chunk size " << chunkSize << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
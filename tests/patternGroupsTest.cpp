@@ -0,0 +1,149 @@
+#include "BasicTestHelpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <utility>
+
+typedef std::string StringClass;
+typedef std::tuple<size_t, StringClass> FoundMatch;
+
+// tenants share some patterns ("abc" is in groups 0 and 2), "zz" has no group
+static std::vector<StringClass> strings = { "abc", "bc", "c", "abcab", "ca", "abc", "bca", "b", "cab", "zz" };
+static std::vector<uint8_t> groups =      { 0,     1,    2,   0,       1,    2,     0,     3,   1,     200 };
+static const size_t groupCount = 4;
+static const char* fileName = "patternGroupsTest.bin";
+
+static StringClass MakeText()
+{
+	StringClass text;
+	uint32_t seed = 7;
+	for (size_t i = 0; i < 5000; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		text += "abcz"[(seed >> 16) % 4];
+	}
+
+	return text;
+}
+
+static auto Collector(std::vector<FoundMatch>& found)
+{
+	return [&found](const AhoCorasick::Match<StringClass>& m)
+	{
+		found.emplace_back(m.offset, *m.word);
+		return true;
+	};
+}
+
+template <AhoCorasick::PerformanceStrategy strategy, AhoCorasick::MatchKind kind>
+static bool GroupsTest()
+{
+	typedef AhoCorasick::Scanner<StringClass, strategy, kind> ScannerType;
+	AhoCorasick::ScannerOptions options;
+	options.groups = groups;
+	ScannerType scanner(strings.begin(), strings.end(), options);
+	const StringClass text = MakeText();
+
+	// duplicate is reported with the first index, its mask has both groups
+	if (scanner.GetPatternGroups(0) != 5 || scanner.GetPatternGroups(8) != 0)
+		return false;
+
+	for (uint64_t mask = 0; mask < (1 << groupCount); ++mask)
+	{
+		// reference is a scanner of the patterns selected only
+		std::vector<StringClass> selected;
+		for (size_t i = 0; i < strings.size(); ++i)
+		{
+			if (groups[i] < groupCount && (mask & (1ull << groups[i])) != 0)
+				selected.push_back(strings[i]);
+		}
+
+		std::vector<FoundMatch> expected, found;
+		if (!selected.empty())
+		{
+			ScannerType reference(selected.begin(), selected.end());
+			reference.Scan(Collector(expected), text.cbegin(), text.cend());
+		}
+
+		scanner.ScanGroups(mask, Collector(found), text.cbegin(), text.cend());
+		if (found != expected)
+			return false;
+	}
+
+	// all groups disable filtering
+	std::vector<FoundMatch> expected, found;
+	scanner.Scan(Collector(expected), text.cbegin(), text.cend());
+	scanner.ScanGroups(AhoCorasick::AllGroups, Collector(found), text.cbegin(), text.cend());
+	return found == expected;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool GroupsTestAll()
+{
+	return GroupsTest<strategy, AhoCorasick::MatchKind::All>()
+		&& GroupsTest<strategy, AhoCorasick::MatchKind::Existence>()
+		&& GroupsTest<strategy, AhoCorasick::MatchKind::LeftmostFirst>()
+		&& GroupsTest<strategy, AhoCorasick::MatchKind::LeftmostLongest>();
+}
+
+static bool SerializationTest()
+{
+	typedef AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa> ScannerType;
+	AhoCorasick::ScannerOptions options;
+	options.groups = groups;
+	ScannerType scanner(strings.begin(), strings.end(), options);
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		if (!scanner.Save(stream))
+			return false;
+	}
+
+	auto loaded = ScannerType::Load(fileName);
+	if (!loaded || loaded->GetPatternGroups(0) != scanner.GetPatternGroups(0))
+		return false;
+
+	const StringClass text = MakeText();
+	std::vector<std::pair<size_t, size_t>> expected, found;
+	scanner.ScanGroups(2, [&expected](const AhoCorasick::Match<StringClass>& m) { expected.emplace_back(m.offset, m.index); return true; },
+		text.cbegin(), text.cend());
+	loaded->ScanGroups(2, [&found](const AhoCorasick::Match<StringClass>& m) { found.emplace_back(m.offset, m.index); return true; },
+		text.cbegin(), text.cend());
+
+	return !expected.empty() && found == expected;
+}
+
+static bool NoGroupsTest()
+{
+	// every pattern is in group 0
+	AhoCorasick::Scanner<StringClass> scanner(strings.begin(), strings.end());
+	const StringClass text = MakeText();
+	size_t count = 0;
+	auto callback = [&count](const AhoCorasick::Match<StringClass>&) { ++count; return true; };
+	scanner.ScanGroups(2, callback, text.cbegin(), text.cend());
+	if (count != 0 || scanner.GetPatternGroups(3) != 1)
+		return false;
+
+	scanner.ScanGroups(1, callback, text.cbegin(), text.cend());
+	return count != 0;
+}
+
+int main()
+{
+	bool result = GroupsTestAll<AhoCorasick::PerformanceStrategy::Balanced>()
+		&& GroupsTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		&& GroupsTestAll<AhoCorasick::PerformanceStrategy::Dfa>()
+		&& GroupsTestAll<AhoCorasick::PerformanceStrategy::Adaptive>()
+		&& SerializationTest()
+		&& NoGroupsTest();
+
+	std::remove(fileName);
+	if (!result)
+	{
+		std::cerr << "Pattern groups test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,44 @@
+#include "BasicTestHelpers.hpp"
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+// Long text without pattern starting characters except a few places around vector boundaries,
+// so most of the input is skipped by root filter.
+static bool SparseTest(const std::vector<StringClass>& strings)
+{
+	StringClass text(1000, '.');
+	std::vector<size_t> positions = { 0, 12, 16, 28, 32, 48, 500, 994 };
+	std::vector<StringMatch> expected;
+	for (size_t position : positions)
+	{
+		size_t index = position % strings.size();
+		text.replace(position, strings[index].size(), strings[index]);
+		expected.push_back(MakeMatch<StringMatch>(position, index, strings));
+	}
+
+	return BasicStrTestAllStrategies(text, expected, strings);
+}
+
+int main()
+{
+	if (!SparseTest({ "abc" }))
+	{
+		std::cerr << "Single start character test failed\n";
+		return 1;
+	}
+
+	if (!SparseTest({ "abc", "bcd", "cde" }))
+	{
+		std::cerr << "Three start characters test failed\n";
+		return 2;
+	}
+
+	if (!SparseTest({ "abc", "bcd", "cde", "xyz", "Q", "r!", "\xF0\x9F", "01", "9" }))
+	{
+		std::cerr << "Many start characters test failed\n";
+		return 3;
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+#include "BasicTestHelpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+
+typedef std::string StringClass;
+typedef std::vector<std::pair<size_t, size_t>> MatchList;
+
+// single 'character' patterns and pairs reporting after the first 'character' can't be consumed at once
+static std::vector<StringClass> strings = { "a", "ab", "abc", "b", "bca", "cab", "ca", "xyzzy", "zz", "hello", "He", "o w" };
+static const char* fileName = "rootPairTableTest.bin";
+
+static StringClass MakeText()
+{
+	StringClass text;
+	uint32_t seed = 12345;
+	for (size_t i = 0; i < 20000; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		text += "abcxyzhelo HW"[(seed >> 16) % 13];
+	}
+
+	return text;
+}
+
+template <class ScannerType, class InputIt>
+static MatchList Collect(ScannerType& scanner, InputIt begin, InputIt end)
+{
+	MatchList found;
+	scanner.Scan([&found](const AhoCorasick::Match<StringClass>& m)
+	{
+		found.emplace_back(m.offset, m.index);
+		return true;
+	}, begin, end);
+
+	return found;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool PairTableTest(AhoCorasick::Normalization normalization)
+{
+	typedef AhoCorasick::Scanner<StringClass, strategy> ScannerType;
+	AhoCorasick::ScannerOptions options;
+	options.engine = AhoCorasick::ScannerEngine::Automaton;
+	options.normalization = normalization;
+	ScannerType plain(strings.begin(), strings.end(), options);
+	options.rootPairTable = true;
+	ScannerType paired(strings.begin(), strings.end(), options);
+
+	const StringClass text = MakeText();
+	MatchList expected = Collect(plain, text.cbegin(), text.cend());
+	if (expected.empty() || Collect(paired, text.cbegin(), text.cend()) != expected)
+		return false;
+
+	// single pass input is scanned 'character' by 'character'
+	std::istringstream stream(text);
+	if (Collect(paired, std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()) != expected)
+		return false;
+
+	// packets of one and two 'characters' split pairs
+	MatchList streamed;
+	AhoCorasick::ScanState state;
+	for (size_t offset = 0; offset < text.size(); offset += 1 + offset % 2)
+	{
+		size_t size = std::min<size_t>(1 + offset % 2, text.size() - offset);
+		paired.Scan(state, text.cbegin() + offset, text.cbegin() + offset + size, [&streamed](const AhoCorasick::Match<StringClass>& m)
+		{
+			streamed.emplace_back(m.offset, m.index);
+			return true;
+		});
+	}
+
+	if (streamed != expected)
+		return false;
+
+	auto stats = paired.GetAutomatonStats();
+	if (stats.auxiliaryBytes < 256 * 256 * sizeof(AhoCorasick::NodeId) + plain.GetAutomatonStats().auxiliaryBytes)
+		return false;
+
+	{
+		std::ofstream file(fileName, std::ios::binary);
+		if (!paired.Save(file))
+			return false;
+	}
+
+	auto loaded = ScannerType::Load(fileName);
+	return loaded && loaded->GetAutomatonStats().auxiliaryBytes == stats.auxiliaryBytes 
+		&& Collect(*loaded, text.cbegin(), text.cend()) == expected;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool PairTableTestAll()
+{
+	return PairTableTest<strategy>(AhoCorasick::Normalization::None)
+		&& PairTableTest<strategy>(AhoCorasick::Normalization::AsciiCaseFolding);
+}
+
+int main()
+{
+	bool result = PairTableTestAll<AhoCorasick::PerformanceStrategy::Balanced>()
+		&& PairTableTestAll<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		&& PairTableTestAll<AhoCorasick::PerformanceStrategy::Dfa>()
+		&& PairTableTestAll<AhoCorasick::PerformanceStrategy::Adaptive>();
+
+	std::remove(fileName);
+	if (!result)
+	{
+		std::cerr << "Root pair table test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include "BasicTestHelpers.hpp"
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something" };
+
+// two interleaved streams split into packets at arbitrary positions
+static const StringClass streams[] = { "First word is hello, the secoind one is world", "And lets add something else, bla-bla" };
+static const size_t packetSize[] = { 3, 7 };
+
+int main()
+{
+	AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa> scanner(strings.begin(), strings.end());
+
+	std::vector<StringMatch> expected[2];
+	for (size_t i = 0; i < 2; ++i)
+	{
+		scanner.Scan([&expected, i](const StringMatch& m)
+		{
+			expected[i].emplace_back(m.offset, m.index, m.word);
+			return true;
+		}, streams[i].cbegin(), streams[i].cend());
+	}
+
+	AhoCorasick::ScanState states[2];
+	std::vector<StringMatch> found[2];
+	for (size_t position = 0; position < streams[0].size() || position < streams[1].size(); )
+	{
+		for (size_t i = 0; i < 2; ++i)
+		{
+			size_t first = std::min(position * packetSize[i], streams[i].size());
+			size_t last = std::min(first + packetSize[i], streams[i].size());
+			scanner.Scan(states[i], streams[i].cbegin() + first, streams[i].cbegin() + last, [&found, i](const StringMatch& m)
+			{
+				found[i].emplace_back(m.offset, m.index, m.word);
+				return true;
+			});
+		}
+
+		++position;
+		if (position * packetSize[0] >= streams[0].size() && position * packetSize[1] >= streams[1].size())
+			break;
+	}
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (states[i].offset != streams[i].size() || found[i].size() != expected[i].size()
+			|| !std::equal(expected[i].begin(), expected[i].end(), found[i].begin(), compareMatches<StringMatch>))
+		{
+			std::cerr << "Stream " << i << " test failed\n";
+			return 1;
+		}
+	}
+
+	// stop and resume
+	AhoCorasick::ScanState state;
+	std::vector<StringMatch> resumed;
+	auto stopping = [&resumed](const StringMatch& m)
+	{
+		resumed.emplace_back(m.offset, m.index, m.word);
+		return false;
+	};
+
+	auto begin = streams[0].cbegin();
+	while (!scanner.Scan(state, begin + (size_t)state.offset, streams[0].cend(), stopping));
+
+	if (resumed.size() != expected[0].size() 
+		|| !std::equal(expected[0].begin(), expected[0].end(), resumed.begin(), compareMatches<StringMatch>))
+	{
+		std::cerr << "Stop/resume test failed\n";
+		return 2;
+	}
+
+	return 0;
+}
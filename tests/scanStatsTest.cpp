@@ -0,0 +1,68 @@
+#include "BasicTestHelpers.hpp"
+
+#include <numeric>
+#include <sstream>
+#include <string>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something", "he", "hell" };
+static const StringClass text = "First word is hello, the secoind one is world. And lets add something else, bla-bla-bla, hell";
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool StatsTest()
+{
+	AhoCorasick::Scanner<StringClass, strategy> scanner(strings.begin(), strings.end());
+
+	std::vector<StringMatch> expected;
+	scanner.Scan([&expected](const StringMatch& m)
+	{
+		expected.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	AhoCorasick::ScanStats stats;
+	std::vector<StringMatch> found;
+	scanner.ScanWithStats(stats, [&found](const StringMatch& m)
+	{
+		found.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	if (expected.size() != found.size() || !std::equal(expected.begin(), expected.end(), found.begin(), compareMatches<StringMatch>))
+		return false;
+
+	// every 'character' is either fed to the automaton or skipped by the root filter
+	auto visits = std::accumulate(stats.depths.begin(), stats.depths.end(), (uint64_t)0);
+	if (stats.symbols + stats.skipped != text.size() || visits != stats.symbols || stats.callbacks != found.size()
+		|| stats.chainSteps < stats.callbacks)
+		return false;
+
+	// "hello, " leaves "hello" state, failure links are followed
+	if ((strategy == AhoCorasick::PerformanceStrategy::Dfa) != (stats.failureHops == 0))
+		return false;
+
+	// counters are accumulated
+	scanner.ScanWithStats(stats, [](const StringMatch&) { return true; }, text.cbegin(), text.cend());
+	if (stats.callbacks != found.size() * 2)
+		return false;
+
+	std::ostringstream stream;
+	stats.Export(stream);
+	return stream.str().find("\"callbacks\":" + std::to_string(found.size() * 2) + ",") != std::string::npos;
+}
+
+int main()
+{
+	if (!StatsTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !StatsTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !StatsTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !StatsTest<AhoCorasick::PerformanceStrategy::Adaptive>())
+	{
+		std::cerr << "Scan stats test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
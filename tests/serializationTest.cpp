@@ -0,0 +1,109 @@
+#include "BasicTestHelpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static std::vector<StringClass> strings = { "hello", "world", "bla-bla", "orld", "orl", "something", "he", "hell" };
+static const StringClass text = "First word is hello, the secoind one is world. And lets add something else, bla-bla-bla, hell";
+static const char* fileName = "serializationTest.bin";
+
+static bool compareLoaded(const StringMatch& built, const StringMatch& loaded)
+{
+	return built.offset == loaded.offset && built.index == loaded.index && built.length == loaded.length
+		&& loaded.word == nullptr;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool SaveLoadTest()
+{
+	typedef AhoCorasick::Scanner<StringClass, strategy> ScannerType;
+	ScannerType scanner(strings.begin(), strings.end());
+
+	std::vector<StringMatch> expected;
+	scanner.Scan([&expected](const StringMatch& m)
+	{
+		expected.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		if (!scanner.Save(stream))
+			return false;
+	}
+
+	auto loaded = ScannerType::Load(fileName);
+	if (!loaded || loaded->GetEngine() != AhoCorasick::ScannerEngine::Automaton)
+		return false;
+
+	std::vector<StringMatch> found;
+	loaded->Scan([&found](const StringMatch& m)
+	{
+		found.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return expected.size() == found.size() && std::equal(expected.begin(), expected.end(), found.begin(), compareLoaded);
+}
+
+static bool CorruptedFileTest()
+{
+	AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa> scanner(strings.begin(), strings.end());
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		if (!scanner.Save(stream))
+			return false;
+	}
+
+	// file written for another strategy or 'character' type must be rejected
+	if (AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Balanced>::Load(fileName)
+		|| AhoCorasick::Scanner<std::wstring, AhoCorasick::PerformanceStrategy::Balanced>::Load(fileName))
+		return false;
+
+	std::string content;
+	{
+		std::ifstream stream(fileName, std::ios::binary);
+		content.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+
+	// truncated file
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		stream.write(content.data(), content.size() / 2);
+	}
+
+	if (AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa>::Load(fileName))
+		return false;
+
+	// broken magic
+	content[0] = 'X';
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		stream.write(content.data(), content.size());
+	}
+
+	return !AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa>::Load(fileName)
+		&& !AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa>::Load("nonexistentFile.bin");
+}
+
+int main()
+{
+	bool result = SaveLoadTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		&& SaveLoadTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		&& SaveLoadTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		&& SaveLoadTest<AhoCorasick::PerformanceStrategy::Adaptive>()
+		&& CorruptedFileTest();
+
+	std::remove(fileName);
+	if (!result)
+	{
+		std::cerr << "Serialization test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
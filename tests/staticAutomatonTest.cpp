@@ -0,0 +1,69 @@
+#include "BasicTestHelpers.hpp"
+
+#include <string>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static constexpr const char* keywords[] = { "hello", "world", "bla-bla", "orld", "orl", "something", "he", "hell", "he", "", "a" };
+static constexpr auto automaton = AhoCorasick::MakeStaticAutomaton<AhoCorasick::GetStaticNodeCount(keywords)>(keywords);
+
+// everything is known at compile time
+static_assert(AhoCorasick::GetStaticNodeCount(keywords) == 32, "unexpected node count");
+static_assert(automaton.GetMatchIndex(automaton.Next(automaton.Next(0, 'h'), 'e')) == 6,
+	"'he' must be recognized at compile time");
+static_assert(automaton.GetMatchIndex(automaton.Next(automaton.Next(automaton.Next(0, 'w'), 'o'), 'r')) == 
+	automaton.InvalidIndex, "'wor' is not a pattern");
+
+static const StringClass text = "First word is hello, the secoind one is world. And lets add something else, bla-bla-bla, hell";
+
+static bool StaticAutomatonTest()
+{
+	std::vector<StringClass> strings(std::begin(keywords), std::end(keywords));
+	AhoCorasick::Scanner<StringClass, AhoCorasick::PerformanceStrategy::Dfa> scanner(strings.begin(), strings.end());
+
+	std::vector<StringMatch> expected;
+	scanner.Scan([&expected](const StringMatch& m)
+	{
+		expected.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	std::vector<StringMatch> found;
+	automaton.Scan([&found](const StringMatch& m)
+	{
+		found.push_back(m);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	if (expected.size() != found.size())
+		return false;
+
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		const auto& e = expected[i];
+		const auto& f = found[i];
+		if (e.offset != f.offset || e.index != f.index || e.length != f.length || f.word != nullptr)
+			return false;
+	}
+
+	// stop by callback
+	size_t count = 0;
+	automaton.Scan([&count](const StringMatch&)
+	{
+		return ++count < 3;
+	}, text.cbegin(), text.cend());
+
+	return count == 3;
+}
+
+int main()
+{
+	if (!StaticAutomatonTest())
+	{
+		std::cerr << "Static automaton test failed\n";
+		return 1;
+	}
+
+	return 0;
+}
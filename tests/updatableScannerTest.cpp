@@ -0,0 +1,113 @@
+#include "BasicTestHelpers.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+typedef std::string StringClass;
+typedef AhoCorasick::Match<StringClass> StringMatch;
+
+static const StringClass text = "First word is hello, the secoind one is world. And lets add something else, bla-bla-bla, hell";
+
+template <class ScannerType>
+static std::vector<std::pair<size_t, size_t>> ScanText(ScannerType& scanner)
+{
+	std::vector<std::pair<size_t, size_t>> found;
+	scanner.Scan([&found](const StringMatch& m)
+	{
+		found.emplace_back(m.offset, m.index);
+		return true;
+	}, text.cbegin(), text.cend());
+
+	return found;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool UpdateTest()
+{
+	AhoCorasick::UpdatableScanner<StringClass, strategy> scanner;
+	if (!ScanText(scanner).empty())
+		return false;
+
+	std::vector<StringClass> first = { "hello", "world", "he", "hell" };
+	if (!scanner.Add(first.begin(), first.end()) || scanner.GetVersion() != 1)
+		return false;
+
+	std::vector<std::pair<size_t, size_t>> expected = { { 14, 2 }, { 14, 3 }, { 14, 0 }, { 22, 2 }, { 40, 1 }, { 89, 2 }, { 89, 3 } };
+	if (ScanText(scanner) != expected)
+		return false;
+
+	// duplicates and absent patterns change nothing
+	std::vector<StringClass> absent = { "absent" };
+	if (scanner.Update(first.begin(), first.end(), absent.begin(), absent.end()) || scanner.GetVersion() != 1)
+		return false;
+
+	// ids of remaining patterns are stable, new ones are never reused
+	std::vector<StringClass> removed = { "hell", "world" };
+	std::vector<StringClass> added = { "world", "bla", "orl" };
+	if (!scanner.Update(added.begin(), added.end(), removed.begin(), removed.end()) || scanner.GetVersion() != 2)
+		return false;
+
+	expected = { { 14, 2 }, { 14, 0 }, { 22, 2 }, { 41, 6 }, { 40, 4 }, { 76, 5 }, { 80, 5 }, { 84, 5 }, { 89, 2 } };
+	return ScanText(scanner) == expected;
+}
+
+template <AhoCorasick::PerformanceStrategy strategy>
+static bool ConcurrentTest()
+{
+	AhoCorasick::UpdatableScanner<StringClass, strategy> scanner;
+	std::vector<StringClass> stable = { "hello", "world" };
+	std::vector<StringClass> volatileWords = { "bla", "something", "hell", "is", "e" };
+	scanner.Add(stable.begin(), stable.end());
+
+	// every version contains stable patterns, readers must always find them
+	std::atomic<bool> stop(false);
+	std::atomic<bool> failed(false);
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		readers.emplace_back([&scanner, &stop, &failed]()
+		{
+			while (!stop)
+			{
+				size_t stableCount = 0;
+				scanner.Scan([&stableCount](const StringMatch& m)
+				{
+					stableCount += m.index < 2 ? 1 : 0;
+					return true;
+				}, text.cbegin(), text.cend());
+
+				if (stableCount != 2)
+					failed = true;
+			}
+		});
+	}
+
+	for (size_t i = 0; i < 200; ++i)
+	{
+		scanner.Add(volatileWords.begin(), volatileWords.end());
+		scanner.Remove(volatileWords.begin(), volatileWords.end());
+	}
+
+	stop = true;
+	for (auto& reader : readers)
+		reader.join();
+
+	return !failed && scanner.GetVersion() == 401;
+}
+
+int main()
+{
+	if (!UpdateTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !UpdateTest<AhoCorasick::PerformanceStrategy::MaximumPerformance>()
+		|| !UpdateTest<AhoCorasick::PerformanceStrategy::Dfa>()
+		|| !UpdateTest<AhoCorasick::PerformanceStrategy::Adaptive>()
+		|| !ConcurrentTest<AhoCorasick::PerformanceStrategy::Balanced>()
+		|| !ConcurrentTest<AhoCorasick::PerformanceStrategy::Dfa>())
+	{
+		std::cerr << "Updatable scanner test failed\n";
+		return 1;
+	}
+
+	return 0;
+}